@@ -8,6 +8,17 @@ CONFIG += c++11
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# K9SqlFunctions hands SQL functions to the QSQLITE driver's sqlite3 handles through our own
+# libsqlite3, which is only safe when the driver links that same library (Qt's -system-sqlite).
+# Run qmake with CONFIG+=bundled_sqlite to build without them against a bundled-SQLite driver.
+bundled_sqlite {
+    DEFINES += K9_BUNDLED_SQLITE
+} else {
+    !system(ldd $$[QT_INSTALL_PLUGINS]/sqldrivers/libqsqlite.so | grep -q libsqlite3): \
+        error("Qt's QSQLITE driver isn't linked against the system libsqlite3. Use a Qt built with -system-sqlite, or run qmake with CONFIG+=bundled_sqlite.")
+    LIBS += -lsqlite3
+}
+
 SOURCES += \
     browser.cpp \
     browserview.cpp \
@@ -17,11 +28,13 @@ SOURCES += \
     globals.cpp \
     history.cpp \
     imageview.cpp \
+    k9atom.cpp \
     k9lineedit.cpp \
     k9mimedata.cpp \
     k9portage.cpp \
     k9pushbutton.cpp \
     k9shell.cpp \
+    k9sqlfunctions.cpp \
     k9tabbar.cpp \
     main.cpp \
     tabwidget.cpp \
@@ -36,11 +49,13 @@ HEADERS += \
     globals.h \
     history.h \
     imageview.h \
+    k9atom.h \
     k9lineedit.h \
     k9mimedata.h \
     k9portage.h \
     k9pushbutton.h \
     k9shell.h \
+    k9sqlfunctions.h \
     k9tabbar.h \
     main.h \
     tabwidget.h \
@@ -8,6 +8,17 @@ CONFIG -= app_bundle
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# K9SqlFunctions hands SQL functions to the QSQLITE driver's sqlite3 handles through our own
+# libsqlite3, which is only safe when the driver links that same library (Qt's -system-sqlite).
+# Run qmake with CONFIG+=bundled_sqlite to build without them against a bundled-SQLite driver.
+bundled_sqlite {
+    DEFINES += K9_BUNDLED_SQLITE
+} else {
+    !system(ldd $$[QT_INSTALL_PLUGINS]/sqldrivers/libqsqlite.so | grep -q libsqlite3): \
+        error("Qt's QSQLITE driver isn't linked against the system libsqlite3. Use a Qt built with -system-sqlite, or run qmake with CONFIG+=bundled_sqlite.")
+    LIBS += -lsqlite3
+}
+
 SOURCES += \
         datastorage.cpp \
         globals.cpp \
@@ -15,8 +26,19 @@ SOURCES += \
         k9atom.cpp \
         k9atomaction.cpp \
         k9atomlist.cpp \
+        k9dirwalker.cpp \
+        k9ebuild.cpp \
+        k9eclassindex.cpp \
+        k9metacache.cpp \
+        k9metadata.cpp \
         k9portage.cpp \
+        k9shelllexer.cpp \
+        k9sidetables.cpp \
+        k9sqlfunctions.cpp \
+        k9stats.cpp \
+        k9watcher.cpp \
         main.cpp \
+        vdbrecord.cpp \
         versionstring.cpp
 
 # Default rules for deployment.
@@ -31,8 +53,19 @@ HEADERS += \
     k9atom.h \
     k9atomaction.h \
     k9atomlist.h \
+    k9dirwalker.h \
+    k9ebuild.h \
+    k9eclassindex.h \
+    k9metacache.h \
+    k9metadata.h \
     k9portage.h \
+    k9shelllexer.h \
+    k9sidetables.h \
+    k9sqlfunctions.h \
+    k9stats.h \
+    k9watcher.h \
     main.h \
+    vdbrecord.h \
     versionstring.h
 
 RESOURCES += \
@@ -40,12 +40,15 @@ public:
     bool emptyDatabase;
 
     QString openDatabase(void);
+    QSqlDatabase database(void);
     void createDatabase(QString connectionName, QString databaseFileName, QString scriptFileName);
     bool upgradeDatabase(QSqlQuery& query, QSqlDatabase& db, int schemaVersion);
     bool runSqlScript(QSqlDatabase& db, QString scriptFileName);
 
 private:
     static int connectionCount;
+    qint64 databaseFileId; // inode of the file connectionName was opened on
+    qint64 currentFileId(void);
 };
 
 #endif // DATASTORAGE_H
@@ -23,6 +23,7 @@ bool showProgress = false;
 K9Portage* portage = nullptr;
 QTextStream output(stdout);
 QTextStream error(stderr);
+QMutex outputMutex;
 
 void progress(int i)
 {
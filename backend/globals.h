@@ -19,11 +19,13 @@
 
 #include <QString>
 #include <QTextStream>
+#include <QMutex>
 
 extern bool showProgress;
 extern class K9Portage* portage;
 extern QTextStream output;
 extern QTextStream error;
+extern QMutex outputMutex; // serializes output from import worker threads
 
 void progress(int i);
 
@@ -1,4 +1,4 @@
-// Copyright (c) 2021-2025, K9spud LLC.
+// Copyright (c) 2021-2026, K9spud LLC.
 //
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -16,9 +16,13 @@
 
 #include "importvdb.h"
 #include "datastorage.h"
+#include "k9sqlfunctions.h"
 #include "k9portage.h"
+#include "k9ebuild.h"
+#include "k9dirwalker.h"
+#include "vdbrecord.h"
+#include "k9stats.h"
 #include "globals.h"
-#include "importvdb.h"
 #include "versionstring.h"
 
 #include <QDebug>
@@ -26,6 +30,7 @@
 #include <QFile>
 #include <QFileInfo>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QSqlDatabase>
@@ -34,20 +39,170 @@
 #include <QStringList>
 #include <QVariant>
 #include <QMetaType>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QMutexLocker>
+#include <QSet>
+#include <QCryptographicHash>
+#include <QProcess>
+#include <QMap>
+#include <QVector>
+#include <QDataStream>
+#include <QSaveFile>
+
+#include <cstdio>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const QRegularExpression packageVersionRE = QRegularExpression(QStringLiteral("(.+)-([0-9][0-9,\\-,\\.,[A-z]*)"));
+
+const QString insertPackageSql = QStringLiteral(R"EOF(
+insert into PACKAGE
+(
+    CATEGORYID, REPOID, PACKAGE, DESCRIPTIONID, HOMEPAGEID, VERSION, SLOT, LICENSEID, INSTALLED, OBSOLETED,
+    DOWNLOADSIZE, KEYWORDSID, IUSEID, MASKED, PUBLISHED, STATUS, SUBSLOT,
+    V1, V2, V3, V4, V5, V6, V7, V8, V9, V10, VERSIONKEY
+)
+values
+(
+    ?, ?, ?, ?, ?, ?, ?, ?, ?, ?,
+    ?, ?, ?, ?, ?, ?, ?,
+    ?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?
+)
+)EOF");
+
+// Rewrites a row in place, but only when one of its columns actually differs; otherwise SQLite leaves the page alone.
+const QString updatePackageSql = QStringLiteral(R"EOF(
+update PACKAGE set
+    CATEGORYID=?, REPOID=?, PACKAGE=?, DESCRIPTIONID=?, HOMEPAGEID=?, VERSION=?, SLOT=?, LICENSEID=?, INSTALLED=?, OBSOLETED=?,
+    DOWNLOADSIZE=?, KEYWORDSID=?, IUSEID=?, MASKED=?, PUBLISHED=?, STATUS=?, SUBSLOT=?,
+    V1=?, V2=?, V3=?, V4=?, V5=?, V6=?, V7=?, V8=?, V9=?, V10=?, VERSIONKEY=?
+where PACKAGEID=? and
+(
+    CATEGORYID is not ? or REPOID is not ? or PACKAGE is not ? or DESCRIPTIONID is not ? or HOMEPAGEID is not ? or
+    VERSION is not ? or SLOT is not ? or LICENSEID is not ? or INSTALLED is not ? or OBSOLETED is not ? or
+    DOWNLOADSIZE is not ? or KEYWORDSID is not ? or IUSEID is not ? or MASKED is not ? or PUBLISHED is not ? or
+    STATUS is not ? or SUBSLOT is not ? or
+    V1 is not ? or V2 is not ? or V3 is not ? or V4 is not ? or V5 is not ? or
+    V6 is not ? or V7 is not ? or V8 is not ? or V9 is not ? or V10 is not ? or VERSIONKEY is not ?
+)
+)EOF");
+const int packageColumnCount = 28; // values bound by bindPackage()
+
+const QString insertFingerprintSql = QStringLiteral("insert or replace into FINGERPRINT (PATH, CATEGORYID, PACKAGE, PACKAGEID, STAMP) values(?, ?, ?, ?, ?)");
+
+// What a -shadow reload snapshots of PACKAGE and FINGERPRINT (as BASEPACKAGE and BASEFINGERPRINT),
+// enough to notice the writes of -emerged, -hook and -reload, and the packages that differ
+// between that snapshot and the live file by the time it's swapped in.
+const QString shadowBaseColumns = QStringLiteral("PACKAGEID, CATEGORYID, PACKAGE, VERSION, INSTALLED, DOWNLOADSIZE, OBSOLETED");
+const QString shadowBaseFingerprintColumns = QStringLiteral("PATH, CATEGORYID, PACKAGE, STAMP");
+const QString changedPackagesSql = QStringLiteral(R"EOF(
+select distinct c.CATEGORY, x.PACKAGE from
+(
+    select CATEGORYID, PACKAGE from (select %1 from LIVE.PACKAGE except select * from BASEPACKAGE)
+    union all
+    select CATEGORYID, PACKAGE from (select * from BASEPACKAGE except select %1 from LIVE.PACKAGE)
+    union all
+    select CATEGORYID, PACKAGE from (select %2 from LIVE.FINGERPRINT except select * from BASEFINGERPRINT)
+    union all
+    select CATEGORYID, PACKAGE from (select * from BASEFINGERPRINT except select %2 from LIVE.FINGERPRINT)
+) x
+inner join LIVE.CATEGORY c on c.CATEGORYID = x.CATEGORYID
+)EOF");
+
+// Part of the stamp of ebuilds read by K9Ebuild::ebuildReader(). Bump it when the reader starts
+// reading ebuilds differently, so FINGERPRINT and EBUILDCACHE stop vouching for the old values.
+const int ebuildReaderRevision = 2;
+
+const QString configCacheFileName = QStringLiteral("config.cache");
+const QString emergeLogOffsetFileName = QStringLiteral("emergelog.offset");
+const QRegularExpression emergeLogRE = QRegularExpression(QStringLiteral("^[0-9]+:\\s+(?:::: completed emerge \\([0-9]+ of [0-9]+\\)|>>> unmerge success:) ([^/\\s]+)/(\\S+)"));
+const quint32 configCacheMagic = 0x4b39434b; // "K9CK"
+const qint32 configCacheVersion = 1;
+
+// Parses one category folder on a worker thread, then hands the resulting rows
+// off to the database writer (which stays on the thread that owns the connection).
+class CategoryImporter : public QRunnable
+{
+public:
+    CategoryImporter(ImportVDB* importer, int repoIndex, int categoryId, QStringList packages = QStringList())
+    {
+        this->importer = importer;
+        this->repoIndex = repoIndex;
+        this->categoryId = categoryId;
+        this->packages = packages;
+    }
+
+    void run() override
+    {
+        K9Ebuild ebuild;
+        QList<ImportVDB::PackageRecord> records;
+        if(repoIndex == -1)
+        {
+            importer->importInstalledCategory(ebuild, records, categoryId);
+        }
+        else
+        {
+            importer->importCategory(ebuild, records, repoIndex, categoryId, packages);
+        }
+        importer->queueRecords(records);
+    }
+
+private:
+    ImportVDB* importer;
+    int repoIndex; // index into portage->repos, -1 means /var/db/pkg
+    int categoryId;
+    QStringList packages; // only these package folders, or the whole category when empty
+};
+
+// Recomputes MASKED and STATUS for a slice of PACKAGE rows on a worker thread.
+class MaskEvaluator : public QRunnable
+{
+public:
+    MaskEvaluator(ImportVDB* importer, QVector<ImportVDB::MaskRow>* rows, int first, int last)
+    {
+        this->importer = importer;
+        this->rows = rows;
+        this->first = first;
+        this->last = last;
+    }
+
+    void run() override
+    {
+        for(int i = first; i < last; i++)
+        {
+            importer->remaskRow((*rows)[i]);
+        }
+    }
+
+private:
+    ImportVDB* importer;
+    QVector<ImportVDB::MaskRow>* rows;
+    int first;
+    int last; // one past the final row
+};
 
 ImportVDB::ImportVDB()
 {
+    abort = false;
+    jobs = 1;
+    fullReload = false;
+    reimportAll = false;
+    shadow = false;
+    rowsChanged = 0;
+    stats = nullptr;
 }
 
 int ImportVDB::loadCategories(QStringList& categories, const QString folder)
 {
-    QDir dir;
+    K9DirWalker dir;
     int folderCount = 0;
     int i;
 
-    dir.setPath(folder);
-    dir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
-    QStringList folders = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
+    dir.open(folder);
+    QStringList folders = dir.folders();
     QString s;
     const int foldersCount = folders.count();
     for(i = 0; i < foldersCount; i++)
@@ -65,6 +220,9 @@ int ImportVDB::loadCategories(QStringList& categories, const QString folder)
 
 void ImportVDB::reloadDatabase()
 {
+    QElapsedTimer timer;
+    timer.start();
+
     QSqlDatabase db;
     if(QSqlDatabase::contains("RescanThread") == false)
     {
@@ -79,202 +237,366 @@ void ImportVDB::reloadDatabase()
         }
     }
 
-    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
-    db.open();
+    const QString livePath = ds->storageFolder + ds->databaseFileName;
+    const QString shadowPath = livePath + ".shadow";
+    if(shadow)
+    {
+        if(createShadowDatabase(livePath, shadowPath) == false)
+        {
+            return;
+        }
+
+        // the shadow copy is thrown away on failure, so it doesn't need to survive a crash
+        db.setDatabaseName(shadowPath);
+        db.open();
+        K9SqlFunctions::install(db);
+        {
+            QSqlQuery pragma(db);
+            pragma.exec("pragma journal_mode=OFF");
+            pragma.exec("pragma synchronous=OFF");
+        }
+    }
+    else
+    {
+        db.setDatabaseName(livePath);
+        db.open();
+        K9SqlFunctions::install(db);
+    }
+
+    QStringList changedApps;
+    bool ok = importDatabase(db);
+    if(shadow)
+    {
+        if(ok)
+        {
+            ok = swapShadowDatabase(db, livePath, shadowPath, changedApps);
+        }
+        else
+        {
+            db.close();
+        }
+        QFile::remove(shadowPath);
+    }
+
+    if(ok == false)
+    {
+        return;
+    }
+
+    if(changedApps.isEmpty() == false)
+    {
+        // the shadow was built from a snapshot that doesn't have these writes yet
+        output << "Reloading " << changedApps.join(' ') << Qt::endl;
+        const int importedRows = rowsChanged;
+        reloadApp(changedApps);
+        rowsChanged += importedRows;
+    }
+
+    progress(100);
+    output << QString("Done in %1 seconds using %2 jobs.").arg(static_cast<double>(timer.elapsed()) / 1000.0, 0, 'f', 2).arg(qMax(1, jobs)) << Qt::endl;
+}
 
+bool ImportVDB::importDatabase(QSqlDatabase& db)
+{
     QSqlQuery query(db);
 
     db.transaction();
 
-    if(query.exec("delete from REPO") == false)
+    if(loadRepos(query) == false)
     {
         db.rollback();
-        return;
+        return false;
     }
 
-    QString repo;
-    QString s;
-    QStringList paths;
-    int i;
-    query.prepare("insert into REPO (REPOID, REPO, LOCATION) values(?, ?, ?)");
-    const int repoCount = portage->repos.count();
-    for(i = 0; i < repoCount; i++)
+    // package.mask and friends decide every row's MASKED value. When they've changed since the last reload,
+    // the rows we keep get their masks recomputed in place instead of being re-imported.
+    bool incremental = (fullReload == false);
+    bool remask = false;
+    const QString signature = configSignature();
+    if(query.exec("select CONFIGHASH from META") == false || query.first() == false || query.value(0).toString().isEmpty())
     {
-        query.bindValue(0, i);
-        s = portage->repos.at(i);
-        paths = s.split('/');
-        repo = paths.at(paths.count() - 2);
-        query.bindValue(1, repo);
-        query.bindValue(2, s);
+        incremental = false;
+    }
+    else if(query.value(0).toString() != signature)
+    {
+        remask = true;
+    }
 
-        if(query.exec() == false)
+    // CATEGORYID has to stay stable for the rows we keep, and it doubles as the index into categories.
+    int i;
+    bool contiguous = true;
+    categories.clear();
+    if(query.exec("select CATEGORYID, CATEGORY from CATEGORY order by CATEGORYID") == false)
+    {
+        db.rollback();
+        return false;
+    }
+    while(query.next())
+    {
+        if(query.value(0).toInt() != categories.count())
         {
-            db.rollback();
-            return;
+            contiguous = false;
+            break;
         }
+        categories.append(query.value(1).toString());
     }
 
-    QStringList categories;
-    int folderCount = 0, progressCount = 0;
-    QDir dir;
-    for(i = 0; i < repoCount; i++)
+    if(contiguous == false)
     {
-        folderCount += loadCategories(categories, portage->repos.at(i));
+        categories.clear();
+        incremental = false;
+        if(query.exec("delete from CATEGORY") == false)
+        {
+            db.rollback();
+            return false;
+        }
     }
-    folderCount += loadCategories(categories, "/var/db/pkg/");
 
-    if(query.exec("delete from CATEGORY") == false)
+    const int knownCategoryCount = categories.count();
+    const int repoCount = portage->repos.count();
+    for(i = 0; i < repoCount; i++)
     {
-        db.rollback();
-        return;
+        loadCategories(categories, portage->repos.at(i));
     }
+    loadCategories(categories, portage->vdbFolder);
 
     query.prepare("insert into CATEGORY (CATEGORYID, CATEGORY) values(?, ?)");
     const int categoryCount = categories.count();
-    for(i = 0; i < categoryCount; i++)
+    for(i = knownCategoryCount; i < categoryCount; i++)
     {
         query.bindValue(0, i);
         query.bindValue(1, categories.at(i));
         if(query.exec() == false)
         {
             db.rollback();
-            return;
+            return false;
         }
     }
 
-    if(query.exec("delete from PACKAGE") == false)
+    // a full reload still diffs against the rows we have, so their PACKAGEIDs survive it; only
+    // renumbered categories leave nothing worth comparing against
+    fingerprints.clear();
+    if(contiguous == false && (query.exec("delete from PACKAGE") == false || query.exec("delete from FINGERPRINT") == false))
     {
         db.rollback();
-        return;
+        return false;
     }
 
-    QString category;
-    QString categoryPath;
-    QString buildsPath;
-    QString ebuildFilePath;
-    QString packageName;
-    QString metaCacheFilePath;
-    QFileInfo fi;
-    QDir builds;
-    QStringList packageFolders;
-    QStringList ebuildFiles;
-    int folder;
-    int categoryId;
+    if(query.exec("select PATH, STAMP, PACKAGEID from FINGERPRINT") == false)
+    {
+        db.rollback();
+        return false;
+    }
 
-    query.prepare(R"EOF(
-insert into PACKAGE
-(
-    CATEGORYID, REPOID, PACKAGE, DESCRIPTION, HOMEPAGE, VERSION, SLOT, LICENSE, INSTALLED, OBSOLETED,
-    DOWNLOADSIZE, KEYWORDS, IUSE, MASKED, PUBLISHED, STATUS, SUBSLOT,
-    V1, V2, V3, V4, V5, V6, V7, V8, V9, V10
-)
-values
-(
-    ?, ?, ?, ?, ?, ?, ?, ?, ?, ?,
-    ?, ?, ?, ?, ?, ?, ?,
-    ?, ?, ?, ?, ?, ?, ?, ?, ?, ?
-)
-)EOF");
-    for(int repoId = 0; repoId < repoCount; repoId++)
+    Fingerprint fingerprint;
+    while(query.next())
     {
-        output << QString("Loading %1").arg(portage->repos.at(repoId)) << Qt::endl;
-        for(categoryId = 0; categoryId < categoryCount; categoryId++)
+        fingerprint.stamp = query.value(1).toString();
+        fingerprint.packageId = query.value(2).isNull() ? -1 : query.value(2).toLongLong();
+        fingerprints.insert(query.value(0).toString(), fingerprint);
+    }
+
+    // a database filled in before fingerprints existed has nothing to compare against
+    if(fingerprints.isEmpty())
+    {
+        incremental = false;
+    }
+    reimportAll = (incremental == false);
+
+    // when everything gets re-imported, whatever row isn't claimed by an ebuild along the way is gone
+    packageIds.clear();
+    orphans.clear();
+    claimed.clear();
+    query.prepare("select PACKAGEID, REPOID, CATEGORYID, PACKAGE, VERSION from PACKAGE");
+    if(loadPackageIds(query, reimportAll) == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    // still good on a full reload, that's when it saves the most
+    if(loadEbuildCache(query) == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    // git checkouts only need the package folders touched since the commit we indexed last time
+    QStringList headCommits;
+    deltaPackages.clear();
+    for(i = 0; i < repoCount; i++)
+    {
+        headCommits.append(gitHead(portage->repos.at(i)));
+        if(incremental == false || headCommits.at(i).isEmpty() || repoCommits.at(i).isEmpty())
         {
-            if(abort)
-            {
-                break;
-            }
+            continue;
+        }
 
-            category = categories.at(categoryId);
-            categoryPath = portage->repos.at(repoId);
-            categoryPath.append(category);
-            dir.setPath(categoryPath);
-            if(dir.exists() == false)
+        QSet<QString> packages;
+        if(gitChangedPackages(portage->repos.at(i), repoCommits.at(i), headCommits.at(i), packages))
+        {
+            deltaPackages.insert(i, packages);
+        }
+    }
+
+    if(deltaPackages.isEmpty() == false)
+    {
+        // installing or uninstalling changes an ebuild's fingerprint without touching the repo,
+        // so every package that is (or was last time) installed gets looked at as well.
+        QSet<QString> installed;
+        QRegularExpressionMatch match;
+        K9DirWalker installedRoot;
+        K9DirWalker dir;
+        QString s;
+        installedRoot.open(portage->vdbFolder);
+        for(i = 0; i < categoryCount; i++)
+        {
+            if(dir.openAt(installedRoot, categories.at(i)) == false)
             {
                 continue;
             }
-            packageFolders = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-            const int packageFolderCount = packageFolders.count();
-            for(folder = 0; folder < packageFolderCount; folder++)
+            foreach(s, dir.folders())
             {
-                packageName = packageFolders.at(folder);
-                buildsPath = QString("%1/%2").arg(categoryPath, packageName);
-                builds.setPath(buildsPath);
-                builds.setNameFilters(QStringList("*.ebuild"));
-                ebuildFiles = builds.entryList(QDir::Files);
-                const int ebuildCount = ebuildFiles.count();
-                for(i = 0; i < ebuildCount; i++)
+                match = packageVersionRE.match(s);
+                if(match.hasMatch())
                 {
-                    ebuildFilePath = ebuildFiles.at(i);
-                    query.bindValue(0, categoryId);
-                    query.bindValue(1, repoId);
+                    installed.insert(QString("%1/%2").arg(categories.at(i), match.captured(1)));
+                }
+            }
+        }
 
-                    metaCacheFilePath = QString("%1metadata/md5-cache/%2/%3").arg(portage->repos.at(repoId), category, ebuildFilePath.left(ebuildFilePath.length() - 7));
-                    fi.setFile(metaCacheFilePath);
-                    if(fi.exists())
-                    {
-                        fi.setFile(buildsPath + "/" + ebuildFilePath);
-                        query.bindValue(14, fi.birthTime().toSecsSinceEpoch()); /* published */
+        QHash<QString, Fingerprint>::const_iterator it;
+        for(it = fingerprints.constBegin(); it != fingerprints.constEnd(); ++it)
+        {
+            if(it.value().stamp.endsWith(":installed") == false)
+            {
+                continue;
+            }
 
-                        if(importMetaCache(&query, category, packageName, metaCacheFilePath, ebuildFilePath.mid(packageName.length() + 1, ebuildFilePath.length() - (7 + packageName.length() + 1))) == false)
-                        {
-                            output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                            db.rollback();
-                            return;
-                        }
-                    }
-                    else if(importRepoPackage(&query, category, packageName, buildsPath, ebuildFilePath) == false)
-                    {
-                        output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                        db.rollback();
-                        return;
-                    }
+            for(i = 0; i < repoCount; i++)
+            {
+                s = portage->repos.at(i);
+                if(deltaPackages.contains(i) && it.key().startsWith(s))
+                {
+                    deltaPackages[i].insert(it.key().mid(s.length()).section('/', 0, 1));
                 }
             }
+        }
 
-            progress(100.0f * static_cast<float>(progressCount++) / static_cast<float>(folderCount));
+        QHash<int, QSet<QString>>::iterator delta;
+        for(delta = deltaPackages.begin(); delta != deltaPackages.end(); ++delta)
+        {
+            delta.value().unite(installed);
         }
     }
 
-    output << "Loading /var/db/pkg/" << Qt::endl;
-    for(categoryId = 0; categoryId < categoryCount; categoryId++)
+    // every repo category folder plus every /var/db/pkg category folder is one task for the worker pool.
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, jobs));
+    int categoryId;
+    int taskCount = 0;
+    for(int repoIndex = 0; repoIndex < repoCount; repoIndex++)
     {
-        if(abort)
+        if(deltaPackages.contains(repoIndex))
         {
-            break;
+            output << QString("Loading %1 changes since %2").arg(portage->repos.at(repoIndex), repoCommits.at(repoIndex).left(12)) << Qt::endl;
+
+            QMap<int, QStringList> changedCategories;
+            foreach(const QString& package, deltaPackages.value(repoIndex))
+            {
+                categoryId = categories.indexOf(package.section('/', 0, 0));
+                if(categoryId != -1)
+                {
+                    changedCategories[categoryId].append(package.section('/', 1, 1));
+                }
+            }
+
+            QMap<int, QStringList>::const_iterator changed;
+            for(changed = changedCategories.constBegin(); changed != changedCategories.constEnd(); ++changed)
+            {
+                pool.start(new CategoryImporter(this, repoIndex, changed.key(), changed.value()));
+                taskCount++;
+            }
+            continue;
         }
 
-        category = categories.at(categoryId);
-        categoryPath = QString("/var/db/pkg/%1/").arg(category);
-        dir.setPath(categoryPath);
-        if(dir.exists() == false)
+        output << QString("Loading %1").arg(portage->repos.at(repoIndex)) << Qt::endl;
+        for(categoryId = 0; categoryId < categoryCount; categoryId++)
         {
-            continue;
+            pool.start(new CategoryImporter(this, repoIndex, categoryId));
+            taskCount++;
         }
+    }
+
+    output << "Loading " << portage->vdbFolder << Qt::endl;
+    for(categoryId = 0; categoryId < categoryCount; categoryId++)
+    {
+        pool.start(new CategoryImporter(this, -1, categoryId));
+        taskCount++;
+    }
+
+    if(writeQueuedRecords(db, pool, taskCount) == false)
+    {
+        db.rollback();
+        fingerprints.clear();
+        deltaPackages.clear();
+        return false;
+    }
+    fingerprints.clear();
+    deltaPackages.clear();
+
+    if(incremental && remask && remaskPackages(db) == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    // every repo ebuild has a FINGERPRINT row, so anything else in EBUILDCACHE has been deleted
+    if(saveEbuildCache(query) == false || query.exec("delete from EBUILDCACHE where PATH not in (select PATH from FINGERPRINT)") == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    // reloadApp() leaves replaced strings and the eclasses of deleted rows behind; they're swept up here on the next sync
+    if(sideTables.prune(query) == false || eclassIndex.prune(query) == false)
+    {
+        db.rollback();
+        return false;
+    }
 
-        packageFolders = dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
-        const int packageFolderCount = packageFolders.count();
-        for(i = 0; i < packageFolderCount; i++)
+    query.prepare("update REPO set HEADCOMMIT=? where REPOID=?");
+    for(i = 0; i < repoCount; i++)
+    {
+        query.bindValue(0, headCommits.at(i));
+        query.bindValue(1, repoIds.at(i));
+        if(query.exec() == false)
         {
-            packageName = packageFolders.at(i);
-            query.bindValue(0, categoryId);
-            if(importInstalledPackage(&query, category, packageName) == false)
-            {
-                output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                db.rollback();
-                return;
-            }
+            db.rollback();
+            return false;
         }
+    }
 
-        progress(100.0f * static_cast<float>(progressCount++) / static_cast<float>(folderCount));
+    query.prepare("update META set CONFIGHASH=?");
+    query.bindValue(0, signature);
+    if(query.exec() == false)
+    {
+        db.rollback();
+        return false;
     }
+
     db.commit();
-    progress(100);
-    output << "Done." << Qt::endl;
+    return true;
 }
 
-void ImportVDB::reloadApp(QStringList appsList)
+// Recomputes every row's MASKED and STATUS from the current config without touching the
+// repos, for when only /etc/portage changed.
+bool ImportVDB::remaskDatabase()
 {
+    QElapsedTimer timer;
+    timer.start();
+    rowsChanged = 0;
+
     QSqlDatabase db;
     if(QSqlDatabase::contains("RescanThread") == false)
     {
@@ -291,57 +613,1179 @@ void ImportVDB::reloadApp(QStringList appsList)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
 
     QSqlQuery query(db);
-
     db.transaction();
-
-    query.prepare("delete from PACKAGE where CATEGORYID=(select CATEGORYID from CATEGORY where CATEGORY=?) and PACKAGE=?");
-    int i, repoId, file;
-    QStringList sl;
-    QString categoryPath;
-    QString buildsPath;
-    QString ebuildFilePath;
-    QString metaCacheFilePath;
-    QString category;
-    QString packageName;
-    QFileInfo fi;
-    QDir builds;
-    QStringList ebuildFiles;
-
-    const int appsCount = appsList.count();
-    for(i = 0; i < appsCount; i++)
+    if(remaskPackages(db) == false)
     {
-        sl = appsList.at(i).split('/');
+        db.rollback();
+        return false;
+    }
+
+    query.prepare("update META set CONFIGHASH=?");
+    query.bindValue(0, configSignature());
+    if(query.exec() == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    db.commit();
+    output << QString("Done in %1 seconds using %2 jobs.").arg(static_cast<double>(timer.elapsed()) / 1000.0, 0, 'f', 2).arg(qMax(1, jobs)) << Qt::endl;
+    return true;
+}
+
+bool ImportVDB::remaskPackages(QSqlDatabase& db)
+{
+    QVector<MaskRow> rows;
+    MaskRow row;
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if(query.exec("select PACKAGEID, CATEGORY, PACKAGE, VERSION, SLOT, SUBSLOT, KEYWORDS, MASKED, STATUS from PACKAGE join CATEGORY on CATEGORY.CATEGORYID=PACKAGE.CATEGORYID "
+                  "left join KEYWORDS on KEYWORDS.KEYWORDSID=PACKAGE.KEYWORDSID") == false)
+    {
+        return false;
+    }
+
+    while(query.next())
+    {
+        row.packageId = query.value(0).toLongLong();
+        row.category = query.value(1).toString();
+        row.package = query.value(2).toString();
+        row.version = query.value(3).toString();
+        row.slot = query.value(4).toString();
+        row.subslot = query.value(5).toString();
+        row.keywords = query.value(6).toString();
+        row.masked = query.value(7).toInt();
+        row.status = query.value(8).toLongLong();
+        rows.append(row);
+    }
+    query.finish();
+
+    const int rowCount = rows.count();
+    const int taskCount = qMax(1, jobs) * 4;
+    const int sliceSize = (rowCount + taskCount - 1) / taskCount;
+    QThreadPool pool;
+    pool.setMaxThreadCount(qMax(1, jobs));
+    for(int first = 0; first < rowCount; first += sliceSize)
+    {
+        pool.start(new MaskEvaluator(this, &rows, first, qMin(rowCount, first + sliceSize)));
+    }
+    pool.waitForDone();
+
+    int changedCount = 0;
+    query.prepare("update PACKAGE set MASKED=?, STATUS=? where PACKAGEID=?");
+    for(int i = 0; i < rowCount; i++)
+    {
+        const MaskRow& r = rows.at(i);
+        if(r.changed == false)
+        {
+            continue;
+        }
+
+        query.bindValue(0, r.masked);
+        query.bindValue(1, r.status);
+        query.bindValue(2, r.packageId);
+        if(query.exec() == false)
+        {
+            output << "Couldn't update masks: " << query.lastError().text() << Qt::endl;
+            return false;
+        }
+        changedCount++;
+    }
+
+    output << QString("Remasked %1 of %2 packages.").arg(changedCount).arg(rowCount) << Qt::endl;
+    rowsChanged += changedCount;
+    return true;
+}
+
+void ImportVDB::remaskRow(MaskRow& row)
+{
+    VersionString version;
+    version.parse(row.version);
+
+    K9Atom::maskType masked;
+    qint64 status;
+    const QStringList keywordList = row.keywords.split(' ');
+    applyKeywordMasks(masked, status, keywordList);
+    applyConfigMasks(masked, row.category, row.package, row.slot, row.subslot, keywordList, version);
+
+    row.changed = (masked != row.masked || status != row.status);
+    row.masked = masked;
+    row.status = status;
+}
+
+// Snapshots the live database into shadowPath, so an incremental reload has the previous rows and fingerprints to work from.
+bool ImportVDB::createShadowDatabase(QString livePath, QString shadowPath)
+{
+    QFile::remove(shadowPath);
+
+    bool ok;
+    {
+        QSqlDatabase live = QSqlDatabase::addDatabase("QSQLITE", "ShadowSource");
+        live.setDatabaseName(livePath);
+        live.open();
+
+        QSqlQuery query(live);
+        ok = query.exec(QString("vacuum into '%1'").arg(QString(shadowPath).replace('\'', "''")));
+        if(ok == false)
+        {
+            output << "Couldn't create shadow database:" << query.lastError().text() << Qt::endl;
+        }
+        else
+        {
+            // remember what the snapshot looked like, so swapShadowDatabase() can tell which packages
+            // somebody else wrote to the live file while the shadow was being rebuilt
+            query.prepare("attach database ? as SHADOW");
+            query.bindValue(0, shadowPath);
+            ok = query.exec() &&
+                 query.exec(QString("create table SHADOW.BASEPACKAGE as select %1 from SHADOW.PACKAGE").arg(shadowBaseColumns)) &&
+                 query.exec(QString("create table SHADOW.BASEFINGERPRINT as select %1 from SHADOW.FINGERPRINT").arg(shadowBaseFingerprintColumns));
+            if(ok == false)
+            {
+                output << "Couldn't snapshot packages into shadow database:" << query.lastError().text() << Qt::endl;
+            }
+            query.exec("detach database SHADOW");
+        }
+        live.close();
+    }
+    QSqlDatabase::removeDatabase("ShadowSource");
+
+    // the backend often runs as root; the GUI still has to be able to write the file once it's renamed over the live one
+    struct stat sb;
+    if(ok && stat(QFile::encodeName(livePath).constData(), &sb) == 0)
+    {
+        if(chown(QFile::encodeName(shadowPath).constData(), sb.st_uid, sb.st_gid) != 0 ||
+           chmod(QFile::encodeName(shadowPath).constData(), sb.st_mode & 07777) != 0)
+        {
+            output << "Couldn't copy ownership of " << livePath << " to " << shadowPath << ": " << strerror(errno) << Qt::endl;
+            QFile::remove(shadowPath);
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+// Renames the rebuilt shadow database over the live one. The GUI keeps writing window and tab
+// state to the live file while we import, so those tables are carried over first, with the
+// live file write-locked until the rename is done. Packages that -emerged, -hook, -reload or
+// the GUI changed in the live file meanwhile are listed in changedApps, to be reloaded again.
+bool ImportVDB::swapShadowDatabase(QSqlDatabase& db, QString livePath, QString shadowPath, QStringList& changedApps)
+{
+    bool ok = true;
+    {
+        QSqlDatabase live = QSqlDatabase::addDatabase("QSQLITE", "ShadowTarget");
+        live.setDatabaseName(livePath);
+        live.open();
+
+        QSqlQuery lock(live);
+        QSqlQuery query(db);
+        if(lock.exec("begin immediate") == false)
+        {
+            output << "Couldn't lock live database:" << lock.lastError().text() << Qt::endl;
+            ok = false;
+        }
+        else
+        {
+            query.prepare("attach database ? as LIVE");
+            query.bindValue(0, livePath);
+            if(query.exec() == false ||
+               query.exec("delete from WINDOW") == false ||
+               query.exec("insert into WINDOW select * from LIVE.WINDOW") == false ||
+               query.exec("delete from TAB") == false ||
+               query.exec("insert into TAB select * from LIVE.TAB") == false)
+            {
+                output << "Couldn't copy window state into shadow database:" << query.lastError().text() << Qt::endl;
+                ok = false;
+            }
+
+            if(ok)
+            {
+                ok = query.exec(QString(changedPackagesSql).arg(shadowBaseColumns, shadowBaseFingerprintColumns));
+                while(ok && query.next())
+                {
+                    changedApps.append(QString("%1/%2").arg(query.value(0).toString(), query.value(1).toString()));
+                }
+
+                if(ok == false || query.exec("drop table BASEPACKAGE") == false || query.exec("drop table BASEFINGERPRINT") == false)
+                {
+                    output << "Couldn't compare shadow database with live database:" << query.lastError().text() << Qt::endl;
+                    ok = false;
+                }
+            }
+            query.exec("detach database LIVE");
+            db.close();
+
+            if(ok && ::rename(QFile::encodeName(shadowPath).constData(), QFile::encodeName(livePath).constData()) != 0)
+            {
+                output << "Couldn't rename " << shadowPath << " to " << livePath << ": " << strerror(errno) << Qt::endl;
+                ok = false;
+            }
+
+            lock.exec("rollback");
+        }
+        live.close();
+    }
+    QSqlDatabase::removeDatabase("ShadowTarget");
+
+    return ok;
+}
+
+bool ImportVDB::loadRepos(QSqlQuery& query)
+{
+    QHash<QString, int> knownRepos;
+    int nextRepoId = 0;
+    int repoId;
+    QHash<QString, QString> knownCommits;
+    if(query.exec("select REPOID, LOCATION, HEADCOMMIT from REPO") == false)
+    {
+        return false;
+    }
+    while(query.next())
+    {
+        repoId = query.value(0).toInt();
+        knownRepos.insert(query.value(1).toString(), repoId);
+        knownCommits.insert(query.value(1).toString(), query.value(2).toString());
+        nextRepoId = qMax(nextRepoId, repoId + 1);
+    }
+
+    QString s;
+    QStringList paths;
+    repoIds.clear();
+    repoCommits.clear();
+    query.prepare("insert into REPO (REPOID, REPO, LOCATION) values(?, ?, ?)");
+    const int repoCount = portage->repos.count();
+    for(int i = 0; i < repoCount; i++)
+    {
+        s = portage->repos.at(i);
+        repoCommits.append(knownCommits.value(s));
+        if(knownRepos.contains(s))
+        {
+            repoIds.append(knownRepos.value(s));
+            continue;
+        }
+
+        paths = s.split('/');
+        query.bindValue(0, nextRepoId);
+        query.bindValue(1, paths.at(paths.count() - 2));
+        query.bindValue(2, s);
+        if(query.exec() == false)
+        {
+            return false;
+        }
+        repoIds.append(nextRepoId++);
+    }
+
+    return true;
+}
+
+QString ImportVDB::gitHead(QString repoFolder)
+{
+    if(QFileInfo::exists(repoFolder + ".git") == false)
+    {
+        return QString();
+    }
+
+    QProcess git;
+    git.start("git", QStringList() << "-C" << repoFolder << "rev-parse" << "--verify" << "HEAD");
+    if(git.waitForFinished(-1) == false || git.exitStatus() != QProcess::NormalExit || git.exitCode() != 0)
+    {
+        return QString();
+    }
+
+    return QString::fromLatin1(git.readAllStandardOutput()).trimmed();
+}
+
+// Collects the "category/package" folders touched between two commits. Returns false when the
+// repo has to be walked in full instead (git failed, or an eclass changed and could affect any ebuild).
+bool ImportVDB::gitChangedPackages(QString repoFolder, QString fromCommit, QString toCommit, QSet<QString>& packages)
+{
+    if(fromCommit == toCommit)
+    {
+        return true;
+    }
+
+    QProcess git;
+    git.start("git", QStringList() << "-C" << repoFolder << "diff" << "--name-only" << "--no-renames" << fromCommit << toCommit);
+    if(git.waitForFinished(-1) == false || git.exitStatus() != QProcess::NormalExit || git.exitCode() != 0)
+    {
+        QMutexLocker lock(&outputMutex);
+        output << "git diff failed in " << repoFolder << ", scanning the whole repo." << Qt::endl;
+        return false;
+    }
+
+    QRegularExpressionMatch match;
+    QStringList parts;
+    QList<QByteArray> lines = git.readAllStandardOutput().split('\n');
+    const int lineCount = lines.count();
+    for(int i = 0; i < lineCount; i++)
+    {
+        parts = QString::fromUtf8(lines.at(i)).split('/');
+        if(parts.first() == "eclass")
+        {
+            return false;
+        }
+
+        if(parts.count() == 4 && parts.at(0) == "metadata" && parts.at(1) == "md5-cache")
+        {
+            match = packageVersionRE.match(parts.at(3));
+            if(match.hasMatch())
+            {
+                packages.insert(QString("%1/%2").arg(parts.at(2), match.captured(1)));
+            }
+        }
+        else if(parts.count() >= 3)
+        {
+            packages.insert(QString("%1/%2").arg(parts.at(0), parts.at(1)));
+        }
+    }
+
+    return true;
+}
+
+// True when path belongs to a repo that was indexed from a git diff, but outside the package folders that changed.
+bool ImportVDB::skippedByDelta(const QString& path)
+{
+    QHash<int, QSet<QString>>::const_iterator it;
+    for(it = deltaPackages.constBegin(); it != deltaPackages.constEnd(); ++it)
+    {
+        const QString& repoFolder = portage->repos.at(it.key());
+        if(path.startsWith(repoFolder))
+        {
+            return it.value().contains(path.mid(repoFolder.length()).section('/', 0, 1)) == false;
+        }
+    }
+
+    return false;
+}
+
+// mtime:size:revision, the same way ebuildStamp() identifies ebuilds in repos without an md5-cache.
+static QString statxStamp(const struct statx& sx)
+{
+    return QString("%1:%2:r%3").arg(static_cast<qint64>(sx.stx_mtime.tv_sec) * 1000 + sx.stx_mtime.tv_nsec / 1000000).arg(static_cast<qint64>(sx.stx_size)).arg(ebuildReaderRevision);
+}
+
+// Returns the file's birth time in seconds, or -1 when it doesn't exist; one statx() answers both.
+static qint64 birthTime(int dirFd, const QString& path, QString* stamp = nullptr)
+{
+    struct statx sx;
+    if(statx(dirFd, QFile::encodeName(path).constData(), AT_STATX_SYNC_AS_STAT, STATX_BTIME | STATX_MTIME | STATX_SIZE, &sx) != 0)
+    {
+        return -1;
+    }
+
+    if(stamp)
+    {
+        *stamp = statxStamp(sx);
+    }
+    return (sx.stx_mask & STATX_BTIME) ? sx.stx_btime.tv_sec : 0;
+}
+
+// The eclass names out of an md5-cache _eclasses_ value, which alternates them with their md5s
+// on one tab separated line, as one space separated list.
+static QString eclassNames(const K9MetaCache& metaCache)
+{
+    QString names;
+    const char* p = metaCache.data(K9Metadata::eclasses);
+    const char* end = p + metaCache.size(K9Metadata::eclasses);
+    const char* tab;
+    bool name = true;
+    while(p < end)
+    {
+        tab = static_cast<const char*>(memchr(p, '\t', end - p));
+        if(tab == nullptr)
+        {
+            tab = end;
+        }
+
+        if(name && tab > p)
+        {
+            if(names.isEmpty() == false)
+            {
+                names.append(' ');
+            }
+            names.append(QString::fromLatin1(p, static_cast<int>(tab - p)));
+        }
+        name = !name;
+        p = tab + 1;
+    }
+    return names;
+}
+
+// Identifies a PACKAGE row across reloads, no matter which ebuild or /var/db/pkg folder it came from.
+static QString packageKey(int repoId, int categoryId, const QString& package, const QString& version)
+{
+    return QString("%1/%2/%3-%4").arg(repoId).arg(categoryId).arg(package, version);
+}
+
+// Adds the PACKAGEID, REPOID, CATEGORYID, PACKAGE, VERSION rows the prepared query selects to packageIds.
+bool ImportVDB::loadPackageIds(QSqlQuery& query, bool orphaned)
+{
+    if(query.exec() == false)
+    {
+        return false;
+    }
+
+    qint64 packageId;
+    while(query.next())
+    {
+        packageId = query.value(0).toLongLong();
+        packageIds.insert(packageKey(query.value(1).isNull() ? -1 : query.value(1).toInt(), query.value(2).isNull() ? -1 : query.value(2).toInt(),
+                                     query.value(3).toString(), query.value(4).toString()), packageId);
+        if(orphaned)
+        {
+            orphans.insert(packageId);
+        }
+    }
+    return true;
+}
+
+bool ImportVDB::deleteOrphans(QSqlQuery& deleteQuery)
+{
+    K9Stats::Timer timer(stats, K9Stats::sql);
+    bool ok = true;
+    foreach(qint64 packageId, orphans)
+    {
+        if(claimed.contains(packageId))
+        {
+            continue;
+        }
+
+        deleteQuery.bindValue(0, packageId);
+        if(deleteQuery.exec() == false)
+        {
+            output << "Query failed:" << deleteQuery.executedQuery() << deleteQuery.lastError().text() << Qt::endl;
+            ok = false;
+            break;
+        }
+    }
+
+    packageIds.clear();
+    orphans.clear();
+    claimed.clear();
+    return ok;
+}
+
+bool ImportVDB::loadEbuildCache(QSqlQuery& query)
+{
+    ebuildCache.clear();
+    freshEbuildCache.clear();
+    if(query.exec("select PATH, STAMP, DESCRIPTION, HOMEPAGE, SLOT, KEYWORDS, IUSE, LICENSE from EBUILDCACHE") == false)
+    {
+        return false;
+    }
+
+    EbuildCacheEntry entry;
+    while(query.next())
+    {
+        entry.stamp = query.value(1).toString();
+        for(int i = 0; i < ebuildCacheVarCount; i++)
+        {
+            entry.values[i] = query.value(i + 2).toString();
+        }
+        ebuildCache.insert(query.value(0).toString(), entry);
+    }
+    return true;
+}
+
+bool ImportVDB::saveEbuildCache(QSqlQuery& query)
+{
+    query.prepare("insert or replace into EBUILDCACHE (PATH, STAMP, DESCRIPTION, HOMEPAGE, SLOT, KEYWORDS, IUSE, LICENSE) values(?, ?, ?, ?, ?, ?, ?, ?)");
+    QHash<QString, EbuildCacheEntry>::const_iterator it;
+    for(it = freshEbuildCache.constBegin(); it != freshEbuildCache.constEnd(); ++it)
+    {
+        query.bindValue(0, it.key());
+        query.bindValue(1, it.value().stamp);
+        for(int i = 0; i < ebuildCacheVarCount; i++)
+        {
+            query.bindValue(i + 2, it.value().values[i]);
+        }
+        if(query.exec() == false)
+        {
+            output << "Couldn't update EBUILDCACHE: " << query.lastError().text() << Qt::endl;
+            return false;
+        }
+    }
+
+    ebuildCache.clear();
+    freshEbuildCache.clear();
+    return true;
+}
+
+// Parses an ebuild from a repo without an md5-cache, unless EBUILDCACHE already has its
+// variables from when the file had the same mtime and size.
+void ImportVDB::readEbuild(K9Ebuild& ebuild, const QString& ebuildPath, const QString& stamp)
+{
+    int i;
+    QHash<QString, EbuildCacheEntry>::const_iterator it = ebuildCache.constFind(ebuildPath);
+    if(stamp.isEmpty() == false && it != ebuildCache.constEnd() && it.value().stamp == stamp)
+    {
+        for(i = 0; i < ebuildCacheVarCount; i++)
+        {
+            ebuild.metadata.setValue(static_cast<K9Metadata::Key>(i), it.value().values[i]);
+        }
+        return;
+    }
+
+    ebuild.ebuildReader(ebuildPath);
+    if(stamp.isEmpty())
+    {
+        return;
+    }
+
+    EbuildCacheEntry entry;
+    entry.stamp = stamp;
+    for(i = 0; i < ebuildCacheVarCount; i++)
+    {
+        entry.values[i] = ebuild.metadata.value(static_cast<K9Metadata::Key>(i));
+    }
+
+    QMutexLocker lock(&ebuildCacheMutex);
+    freshEbuildCache.insert(ebuildPath, entry);
+}
+
+// Identifies an ebuild's contents for incremental reloads: the md5-cache _md5_ (plus
+// _eclasses_, since an eclass update can change IUSE without touching the ebuild), or the
+// ebuild's mtime and size (and the reader's revision) for repos without a cache.
+QString ImportVDB::ebuildStamp(const K9MetaCache* metaCache, qint64 modified, qint64 size, bool installed)
+{
+    QString stamp;
+    if(metaCache)
+    {
+        stamp = QString::fromLatin1(metaCache->data(K9Metadata::md5), metaCache->size(K9Metadata::md5));
+        if(metaCache->size(K9Metadata::eclasses))
+        {
+            stamp.append(':');
+            stamp.append(QString::fromLatin1(QCryptographicHash::hash(QByteArray::fromRawData(metaCache->data(K9Metadata::eclasses), metaCache->size(K9Metadata::eclasses)),
+                                                                      QCryptographicHash::Md5).toHex()));
+        }
+    }
+    else
+    {
+        stamp = QString("%1:%2:r%3").arg(modified).arg(size).arg(ebuildReaderRevision);
+    }
+
+    // installed versions get their row from /var/db/pkg instead, so installing or uninstalling has to count as a change.
+    if(installed)
+    {
+        stamp.append(":installed");
+    }
+
+    return stamp;
+}
+
+void ImportVDB::loadCategoryListing(CategoryListing& listing, int repoIndex, QString category)
+{
+    K9Stats::Timer timer(stats, K9Stats::enumerate, repoIndex);
+    K9DirWalker dir;
+
+    listing.metaCache.clear();
+    if(dir.open(portage->repos.at(repoIndex) + QStringLiteral("metadata/md5-cache/") + category))
+    {
+        foreach(const QString& entry, dir.files())
+        {
+            listing.metaCache.insert(entry);
+        }
+    }
+
+    listing.installed.clear();
+    if(dir.open(portage->vdbFolder + category))
+    {
+        foreach(const QString& entry, dir.folders())
+        {
+            listing.installed.insert(entry);
+        }
+    }
+}
+
+void ImportVDB::importEbuild(K9Ebuild& ebuild, PackageRecord& record, const CategoryListing& listing, int packageFd, int repoIndex, QString category, QString packageName, QString ebuildFileName)
+{
+    const QString repoFolder = portage->repos.at(repoIndex);
+    const QString pf = ebuildFileName.left(ebuildFileName.length() - 7);
+    const QByteArray fileName = QFile::encodeName(ebuildFileName);
+    const bool hasMetaCache = listing.metaCache.contains(pf);
+    const bool installed = listing.installed.contains(pf);
+    QString metaCacheFilePath;
+    QString fileStamp;
+    struct statx sx;
+    bool hasStat = false;
+
+    record.repoId = repoIds.at(repoIndex);
+    record.package = packageName;
+    record.path = repoFolder + category + '/' + packageName + '/' + ebuildFileName;
+
+    if(hasMetaCache)
+    {
+        metaCacheFilePath = repoFolder + QStringLiteral("metadata/md5-cache/") + category + '/' + pf;
+        K9Stats::Timer timer(stats, K9Stats::read, repoIndex);
+        if(ebuild.metaCache.read(metaCacheFilePath))
+        {
+            record.stamp = ebuildStamp(&ebuild.metaCache, 0, 0, installed);
+        }
+        else
+        {
+            {
+                QMutexLocker lock(&outputMutex);
+                output << "md5-cache " << metaCacheFilePath << " could not be opened for reading." << Qt::endl;
+            }
+            record.stamp = ebuildStamp(nullptr, 0, 0, installed);
+        }
+    }
+    else
+    {
+        // everything we'll want to know about the ebuild file in one call, relative to the package folder we already have open
+        hasStat = statx(packageFd, fileName.constData(), AT_STATX_SYNC_AS_STAT, STATX_MTIME | STATX_SIZE | STATX_BTIME, &sx) == 0;
+        record.stamp = ebuildStamp(nullptr, hasStat ? (sx.stx_mtime.tv_sec * 1000 + sx.stx_mtime.tv_nsec / 1000000) : 0, hasStat ? static_cast<qint64>(sx.stx_size) : 0, installed);
+        if(hasStat)
+        {
+            fileStamp = statxStamp(sx);
+        }
+    }
+
+    QHash<QString, Fingerprint>::const_iterator it = fingerprints.constFind(record.path);
+    if(reimportAll == false && it != fingerprints.constEnd() && it.value().stamp == record.stamp)
+    {
+        record.unchanged = true;
+        return;
+    }
+
+    if(installed)
+    {
+        // the /var/db/pkg import provides this version's row
+        record.hasRow = false;
+        return;
+    }
+
+    if(hasStat == false)
+    {
+        hasStat = statx(packageFd, fileName.constData(), AT_STATX_SYNC_AS_STAT, STATX_BTIME, &sx) == 0;
+    }
+    record.published = (hasStat && (sx.stx_mask & STATX_BTIME)) ? sx.stx_btime.tv_sec : 0;
+
+    if(hasMetaCache)
+    {
+        record.hasRow = importMetaCache(ebuild, record, category, packageName, ebuildFileName.mid(packageName.length() + 1, ebuildFileName.length() - (7 + packageName.length() + 1)));
+    }
+    else
+    {
+        record.hasRow = importRepoPackage(ebuild, record, category, packageName, ebuildFileName, fileStamp);
+    }
+}
+
+void ImportVDB::importCategory(K9Ebuild& ebuild, QList<PackageRecord>& records, int repoIndex, int categoryId, const QStringList& packages)
+{
+    QString category = categories.at(categoryId);
+    QString categoryPath = portage->repos.at(repoIndex);
+    categoryPath.append(category);
+
+    K9DirWalker dir;
+    if(dir.open(categoryPath) == false)
+    {
+        return;
+    }
+
+    QString packageName;
+    K9DirWalker builds;
+    QStringList ebuildFiles;
+    PackageRecord record;
+    CategoryListing listing;
+    int i;
+
+    loadCategoryListing(listing, repoIndex, category);
+
+    QStringList packageFolders = packages;
+    if(packageFolders.isEmpty())
+    {
+        K9Stats::Timer timer(stats, K9Stats::enumerate, repoIndex);
+        packageFolders = dir.folders();
+    }
+
+    QElapsedTimer packageTimer;
+    const int packageFolderCount = packageFolders.count();
+    for(int folder = 0; folder < packageFolderCount; folder++)
+    {
+        if(abort)
+        {
+            break;
+        }
+
+        if(stats)
+        {
+            packageTimer.start();
+        }
+
+        packageName = packageFolders.at(folder);
+        {
+            K9Stats::Timer timer(stats, K9Stats::enumerate, repoIndex);
+            if(builds.openAt(dir, packageName) == false)
+            {
+                continue;
+            }
+            ebuildFiles = builds.files(".ebuild");
+        }
+
+        const int ebuildCount = ebuildFiles.count();
+        for(i = 0; i < ebuildCount; i++)
+        {
+            record = PackageRecord();
+            record.categoryId = categoryId;
+            importEbuild(ebuild, record, listing, builds.fd(), repoIndex, category, packageName, ebuildFiles.at(i));
+            records.append(record);
+        }
+
+        if(stats)
+        {
+            stats->addPackage(repoIndex, category + '/' + packageName, packageTimer.nsecsElapsed());
+        }
+    }
+}
+
+void ImportVDB::importInstalledCategory(K9Ebuild& ebuild, QList<PackageRecord>& records, int categoryId)
+{
+    QString category = categories.at(categoryId);
+    QString categoryPath = portage->vdbFolder + category + '/';
+
+    K9DirWalker dir;
+    if(dir.open(categoryPath) == false)
+    {
+        return;
+    }
+
+    PackageRecord record;
+    VdbRecord vdb;
+    QStringList packageFolders;
+    {
+        K9Stats::Timer timer(stats, K9Stats::enumerate, -1);
+        packageFolders = dir.folders();
+    }
+
+    QElapsedTimer packageTimer;
+    const int packageFolderCount = packageFolders.count();
+    for(int i = 0; i < packageFolderCount; i++)
+    {
+        if(abort)
+        {
+            break;
+        }
+
+        if(stats)
+        {
+            packageTimer.start();
+        }
+
+        record = PackageRecord();
+        record.categoryId = categoryId;
+        record.hasRow = importInstalledPackage(ebuild, vdb, record, dir.fd(), category, packageFolders.at(i));
+        records.append(record);
+
+        if(stats)
+        {
+            stats->addPackage(-1, category + '/' + packageFolders.at(i), packageTimer.nsecsElapsed());
+        }
+    }
+}
+
+void ImportVDB::queueRecords(const QList<PackageRecord>& records)
+{
+    QMutexLocker lock(&queueMutex);
+    queue.append(records);
+    queueReady.wakeOne();
+}
+
+bool ImportVDB::writeQueuedRecords(QSqlDatabase& db, QThreadPool& pool, int taskCount)
+{
+    QSqlQuery insertQuery(db);
+    QSqlQuery updateQuery(db);
+    QSqlQuery deleteQuery(db);
+    QSqlQuery fingerprintQuery(db);
+    insertQuery.prepare(insertPackageSql);
+    updateQuery.prepare(updatePackageSql);
+    deleteQuery.prepare("delete from PACKAGE where PACKAGEID=?");
+    fingerprintQuery.prepare(insertFingerprintSql);
+    if(sideTables.load(db) == false || eclassIndex.load(db) == false)
+    {
+        abort = true;
+        pool.clear();
+        pool.waitForDone();
+        queue.clear();
+        return false;
+    }
+
+    QSet<QString> seen;
+    QList<QList<PackageRecord>> batches;
+    int changedCount = 0;
+    int tasksDone = 0;
+    int i, j;
+    while(tasksDone < taskCount)
+    {
+        queueMutex.lock();
+        while(queue.isEmpty())
+        {
+            queueReady.wait(&queueMutex);
+        }
+        batches.swap(queue);
+        queueMutex.unlock();
+
+        const int batchCount = batches.count();
+        for(i = 0; i < batchCount; i++)
+        {
+            const QList<PackageRecord>& records = batches.at(i);
+            const int recordCount = records.count();
+            for(j = 0; j < recordCount; j++)
+            {
+                const PackageRecord& record = records.at(j);
+                seen.insert(record.path);
+                if(record.unchanged)
+                {
+                    const qint64 packageId = fingerprints.value(record.path).packageId;
+                    if(packageId != -1)
+                    {
+                        claimed.insert(packageId);
+                    }
+                    continue;
+                }
+
+                QHash<QString, Fingerprint>::const_iterator previous = fingerprints.constFind(record.path);
+                if(previous == fingerprints.constEnd() || previous.value().stamp != record.stamp)
+                {
+                    // /var/db/pkg entries get rewritten every time, only count the ones that really changed
+                    changedCount++;
+                }
+
+                if(writeRecord(&insertQuery, &updateQuery, &fingerprintQuery, record) == false)
+                {
+                    abort = true;
+                    pool.clear();
+                    pool.waitForDone();
+                    queue.clear();
+                    return false;
+                }
+            }
+
+            progress(100.0f * static_cast<float>(++tasksDone) / static_cast<float>(taskCount));
+        }
+        batches.clear();
+
+        if(abort)
+        {
+            pool.clear();
+            pool.waitForDone();
+            queue.clear();
+            return false;
+        }
+    }
+
+    // anything fingerprinted last time that no worker came across anymore has vanished from disk
+    QSqlQuery removeQuery(db);
+    removeQuery.prepare("delete from FINGERPRINT where PATH=?");
+    int removedCount = 0;
+    K9Stats::Timer timer(stats, K9Stats::sql);
+    QHash<QString, Fingerprint>::const_iterator it;
+    for(it = fingerprints.constBegin(); it != fingerprints.constEnd(); ++it)
+    {
+        if(seen.contains(it.key()) || skippedByDelta(it.key()))
+        {
+            continue;
+        }
+
+        if(it.value().packageId != -1)
+        {
+            orphans.insert(it.value().packageId);
+        }
+
+        removeQuery.bindValue(0, it.key());
+        if(removeQuery.exec() == false)
+        {
+            output << "Query failed:" << removeQuery.executedQuery() << removeQuery.lastError().text() << Qt::endl;
+            return false;
+        }
+        removedCount++;
+    }
+
+    if(deleteOrphans(deleteQuery) == false)
+    {
+        return false;
+    }
+
+    output << QString("%1 changed, %2 removed.").arg(changedCount).arg(removedCount) << Qt::endl;
+    rowsChanged = changedCount + removedCount;
+    return true;
+}
+
+// Writes the record's row over the existing one with the same repo, category, package and version (if any),
+// and remembers its new fingerprint. Rows the path produced last time are left for deleteOrphans().
+bool ImportVDB::writeRecord(QSqlQuery* insertQuery, QSqlQuery* updateQuery, QSqlQuery* fingerprintQuery, const PackageRecord& record)
+{
+    K9Stats::Timer timer(stats, K9Stats::sql);
+    QHash<QString, Fingerprint>::const_iterator it = fingerprints.constFind(record.path);
+    const bool fingerprinted = (it != fingerprints.constEnd());
+    if(fingerprinted && it.value().packageId != -1)
+    {
+        orphans.insert(it.value().packageId);
+    }
+
+    qint64 packageId = -1;
+    if(record.hasRow)
+    {
+        const QString key = packageKey(record.repoId, record.categoryId, record.package, record.version);
+        packageId = packageIds.value(key, -1);
+        if(packageId != -1 && claimed.contains(packageId) == false)
+        {
+            if(bindPackage(updateQuery, record, 0) == false)
+            {
+                return false;
+            }
+            updateQuery->bindValue(packageColumnCount, packageId);
+            if(bindPackage(updateQuery, record, packageColumnCount + 1) == false)
+            {
+                return false;
+            }
+            if(updateQuery->exec() == false)
+            {
+                output << "Query failed:" << updateQuery->executedQuery() << updateQuery->lastError().text() << Qt::endl;
+                return false;
+            }
+        }
+        else
+        {
+            if(insertPackage(insertQuery, record) == false)
+            {
+                output << "Query failed:" << insertQuery->executedQuery() << insertQuery->lastError().text() << Qt::endl;
+                return false;
+            }
+            packageId = insertQuery->lastInsertId().toLongLong();
+            packageIds.insert(key, packageId);
+        }
+        claimed.insert(packageId);
+
+        if(eclassIndex.write(packageId, record.eclasses, record.inherit) == false)
+        {
+            return false;
+        }
+    }
+
+    if(fingerprinted && it.value().stamp == record.stamp && it.value().packageId == packageId)
+    {
+        return true;
+    }
+
+    fingerprintQuery->bindValue(0, record.path);
+    if(record.categoryId == -1)
+    {
+#if QT_VERSION < 0x060000
+        fingerprintQuery->bindValue(1, QVariant(QVariant::Int)); // NULL categoryId
+#else
+        fingerprintQuery->bindValue(1, QVariant(QMetaType::fromType<int>())); // NULL categoryId
+#endif
+    }
+    else
+    {
+        fingerprintQuery->bindValue(1, record.categoryId);
+    }
+    fingerprintQuery->bindValue(2, record.package);
+    if(packageId == -1)
+    {
+#if QT_VERSION < 0x060000
+        fingerprintQuery->bindValue(3, QVariant(QVariant::LongLong)); // NULL packageId
+#else
+        fingerprintQuery->bindValue(3, QVariant(QMetaType::fromType<qint64>())); // NULL packageId
+#endif
+    }
+    else
+    {
+        fingerprintQuery->bindValue(3, packageId);
+    }
+    fingerprintQuery->bindValue(4, record.stamp);
+    if(fingerprintQuery->exec() == false)
+    {
+        output << "Query failed:" << fingerprintQuery->executedQuery() << fingerprintQuery->lastError().text() << Qt::endl;
+        return false;
+    }
+
+    return true;
+}
+
+bool ImportVDB::insertPackage(QSqlQuery* query, const PackageRecord& record)
+{
+    return bindPackage(query, record, 0) && query->exec();
+}
+
+// Binds the record's columns in insertPackageSql order, starting at placeholder first.
+// Fails when a new side table string couldn't be stored.
+bool ImportVDB::bindPackage(QSqlQuery* query, const PackageRecord& record, int first)
+{
+    if(record.categoryId == -1)
+    {
+#if QT_VERSION < 0x060000
+        query->bindValue(first, QVariant(QVariant::Int)); // NULL categoryId
+#else
+        query->bindValue(first, QVariant(QMetaType::fromType<int>())); // NULL categoryId
+#endif
+    }
+    else
+    {
+        query->bindValue(first, record.categoryId);
+    }
+
+    if(record.repoId == -1)
+    {
+#if QT_VERSION < 0x060000
+        query->bindValue(first + 1, QVariant(QVariant::Int)); // NULL repoId
+#else
+        query->bindValue(first + 1, QVariant(QMetaType::fromType<int>())); // NULL repoId
+#endif
+    }
+    else
+    {
+        query->bindValue(first + 1, record.repoId);
+    }
+
+    query->bindValue(first + 2, record.package);
+    if(sideTables.bind(query, first + 3, K9SideTables::description, record.description) == false ||
+       sideTables.bind(query, first + 4, K9SideTables::homepage, record.homepage) == false ||
+       sideTables.bind(query, first + 7, K9SideTables::license, record.license) == false ||
+       sideTables.bind(query, first + 11, K9SideTables::keywords, record.keywords) == false ||
+       sideTables.bind(query, first + 12, K9SideTables::iuse, record.iuse) == false)
+    {
+        return false;
+    }
+    query->bindValue(first + 5, record.version);
+    query->bindValue(first + 6, QVariant(record.slot));
+    query->bindValue(first + 8, record.installed);
+    query->bindValue(first + 9, record.obsoleted);
+    query->bindValue(first + 10, record.downloadSize);
+    query->bindValue(first + 13, record.masked);
+    query->bindValue(first + 14, record.published);
+    query->bindValue(first + 15, record.status);
+    query->bindValue(first + 16, QVariant(record.subslot));
+    for(int i = 0; i < MAXVX; i++)
+    {
+        query->bindValue(first + 17 + i, record.vx[i]);
+    }
+    query->bindValue(first + 27, record.versionKey);
+    return true;
+}
+
+void ImportVDB::reloadApp(QStringList appsList)
+{
+    rowsChanged = 0;
+
+    QSqlDatabase db;
+    if(QSqlDatabase::contains("RescanThread") == false)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE", "RescanThread");
+    }
+    else
+    {
+        db = QSqlDatabase::database("RescanThread");
+        if(db.isValid())
+        {
+            db.close();
+        }
+    }
+
+    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
+    db.open();
+    K9SqlFunctions::install(db);
+
+    db.transaction();
+    if(reloadPackages(db, appsList) == false)
+    {
+        db.rollback();
+        return;
+    }
+
+    db.commit();
+    progress(100);
+}
+
+// Re-imports every version of the given "category/package" apps inside the caller's transaction.
+bool ImportVDB::reloadPackages(QSqlDatabase& db, const QStringList& appsList)
+{
+    QSqlQuery query(db);
+    QSqlQuery categoryQuery(db);
+    QSqlQuery deleteQuery(db);
+    QSqlQuery fingerprintQuery(db);
+
+    if(loadRepos(query) == false || loadEbuildCache(query) == false)
+    {
+        return false;
+    }
+
+    // every version gets parsed again and diffed against the package's existing rows by writeRecord();
+    // rows nothing claims and fingerprints nothing produced anymore are dropped at the end
+    fingerprints.clear();
+    packageIds.clear();
+    orphans.clear();
+    claimed.clear();
+    reimportAll = true;
+
+    QSqlQuery stampQuery(db);
+    stampQuery.prepare("select PATH, STAMP, PACKAGEID from FINGERPRINT where CATEGORYID=(select CATEGORYID from CATEGORY where CATEGORY=?) and PACKAGE=?");
+    QSqlQuery forgetQuery(db);
+    forgetQuery.prepare("delete from FINGERPRINT where PATH=?");
+    query.prepare("select PACKAGEID, REPOID, CATEGORYID, PACKAGE, VERSION from PACKAGE where CATEGORYID=(select CATEGORYID from CATEGORY where CATEGORY=?) and PACKAGE=?");
+    Fingerprint fingerprint;
+    int i, repoIndex, file;
+    QStringList sl;
+    QString categoryPath;
+    QString category;
+    QString packageName;
+    K9DirWalker builds;
+    K9DirWalker dir;
+    QHash<int, CategoryListing> listings;
+    QString listedCategory;
+    QStringList installedFolders;
+    VdbRecord vdb;
+    QStringList ebuildFiles;
+    K9Ebuild ebuild;
+    PackageRecord record;
+    int categoryId;
+
+    const int appsCount = appsList.count();
+    for(i = 0; i < appsCount; i++)
+    {
+        sl = appsList.at(i).split('/');
         category = sl.first();
         packageName = sl.last();
 
+        stampQuery.bindValue(0, category);
+        stampQuery.bindValue(1, packageName);
+        if(stampQuery.exec() == false)
+        {
+            return false;
+        }
+        while(stampQuery.next())
+        {
+            fingerprint.stamp = stampQuery.value(1).toString();
+            fingerprint.packageId = stampQuery.value(2).isNull() ? -1 : stampQuery.value(2).toLongLong();
+            fingerprints.insert(stampQuery.value(0).toString(), fingerprint);
+        }
+
         query.bindValue(0, category);
         query.bindValue(1, packageName);
-        if(query.exec() == false)
+        if(loadPackageIds(query, true) == false)
         {
-            db.rollback();
-            return;
+            return false;
         }
     }
 
     progress(1);
     int progressCount = 2;
 
-    query.prepare(QStringLiteral(R"EOF(
-insert into PACKAGE
-(
-    CATEGORYID, REPOID, PACKAGE, DESCRIPTION, HOMEPAGE, VERSION, SLOT, LICENSE, INSTALLED, OBSOLETED,
-    DOWNLOADSIZE, KEYWORDS, IUSE, MASKED, PUBLISHED, STATUS, SUBSLOT,
-    V1, V2, V3, V4, V5, V6, V7, V8, V9, V10
-)
-values
-(
-    (select CATEGORYID from CATEGORY where CATEGORY=?), ?, ?, ?, ?, ?, ?, ?, ?, ?,
-    ?, ?, ?, ?, ?, ?, ?,
-    ?, ?, ?, ?, ?, ?, ?, ?, ?, ?
-)
-)EOF"));
+    QSqlQuery updateQuery(db);
+    QSet<QString> seen;
+    query.prepare(insertPackageSql);
+    updateQuery.prepare(updatePackageSql);
+    deleteQuery.prepare("delete from PACKAGE where PACKAGEID=?");
+    fingerprintQuery.prepare(insertFingerprintSql);
+    categoryQuery.prepare("select CATEGORYID from CATEGORY where CATEGORY=?");
+    if(sideTables.load(db) == false || eclassIndex.load(db) == false)
+    {
+        return false;
+    }
 
     const int repoCount = portage->repos.count();
     for(i = 0; i < appsCount; i++)
@@ -349,75 +1793,423 @@ values
         sl = appsList.at(i).split('/');
         category = sl.first();
         packageName = sl.last();
-        query.bindValue(0, category);
 
-        for(repoId = 0; repoId < repoCount; repoId++)
+        categoryId = -1;
+        categoryQuery.bindValue(0, category);
+        if(categoryQuery.exec() && categoryQuery.first())
+        {
+            categoryId = categoryQuery.value(0).toInt();
+        }
+
+        if(category != listedCategory)
         {
-            query.bindValue(1, repoId);
+            // apps from the same category share one listing of each md5-cache and /var/db/pkg folder
+            listedCategory = category;
+            listings.clear();
+            installedFolders.clear();
+            if(dir.open(portage->vdbFolder + category))
+            {
+                installedFolders = dir.folders();
+            }
+        }
 
-            categoryPath = portage->repos.at(repoId);
+        for(repoIndex = 0; repoIndex < repoCount; repoIndex++)
+        {
+            categoryPath = portage->repos.at(repoIndex);
             categoryPath.append(category);
 
-            buildsPath = QString("%1/%2").arg(categoryPath, packageName);
-            builds.setPath(buildsPath);
-            builds.setNameFilters(QStringList("*.ebuild"));
-            ebuildFiles = builds.entryList(QDir::Files);
+            if(builds.open(categoryPath + '/' + packageName) == false)
+            {
+                continue;
+            }
+            if(listings.contains(repoIndex) == false)
+            {
+                loadCategoryListing(listings[repoIndex], repoIndex, category);
+            }
+            const CategoryListing& listing = listings[repoIndex];
+            ebuildFiles = builds.files(".ebuild");
             const int ebuildCount = ebuildFiles.count();
             for(file = 0; file < ebuildCount; file++)
             {
-                ebuildFilePath = ebuildFiles.at(file);
-
-                metaCacheFilePath = QString("%1metadata/md5-cache/%2/%3").arg(portage->repos.at(repoId), category, ebuildFilePath.left(ebuildFilePath.length() - 7));
-                fi.setFile(metaCacheFilePath);
-                if(fi.exists())
+                record = PackageRecord();
+                record.categoryId = categoryId;
+                importEbuild(ebuild, record, listing, builds.fd(), repoIndex, category, packageName, ebuildFiles.at(file));
+                if(writeRecord(&query, &updateQuery, &fingerprintQuery, record) == false)
                 {
-                    fi.setFile(buildsPath + "/" + ebuildFilePath);
-                    query.bindValue(14, fi.birthTime().toSecsSinceEpoch()); /* published */
-
-                    if(importMetaCache(&query, category, packageName, metaCacheFilePath, ebuildFilePath.mid(packageName.length() + 1, ebuildFilePath.length() - (7 + packageName.length() + 1))) == false)
-                    {
-                        output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                        db.rollback();
-                        return;
-                    }
+                    return false;
                 }
-                else if(importRepoPackage(&query, category, packageName, buildsPath, ebuildFilePath) == false)
+                seen.insert(record.path);
+                if(fingerprints.contains(record.path) == false || fingerprints.value(record.path).stamp != record.stamp)
                 {
-                    output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                    db.rollback();
-                    return;
+                    rowsChanged++;
                 }
                 progress(progressCount++);
             }
         }
 
-        QString package;
-
-        QStringList packageNameFilter;
-        packageNameFilter << QString("%1-*").arg(packageName);
-
-        QDir dir;
-        categoryPath = QString("/var/db/pkg/%1/").arg(category);
-        dir.setPath(categoryPath);
-        query.bindValue(0, category);
+        const QString packagePrefix = packageName + '-';
+        ebuildFiles.clear();
+        foreach(const QString& folder, installedFolders)
+        {
+            if(folder.startsWith(packagePrefix))
+            {
+                ebuildFiles.append(folder);
+            }
+        }
 
-        ebuildFiles = dir.entryList(packageNameFilter, QDir::Dirs | QDir::NoDotAndDotDot);
         const int ebuildCount = ebuildFiles.count();
         for(file = 0; file < ebuildCount; file++)
         {
-            package = ebuildFiles.at(file);
-            if(importInstalledPackage(&query, category, package) == false)
+            record = PackageRecord();
+            record.categoryId = categoryId;
+            record.hasRow = importInstalledPackage(ebuild, vdb, record, dir.fd(), category, ebuildFiles.at(file));
+            if(record.package != packageName)
             {
-                output << "Query failed:" << query.executedQuery() << query.lastError().text() << Qt::endl;
-                db.rollback();
-                return;
+                // the filter also matches longer package names that merely start with ours
+                continue;
+            }
+
+            if(writeRecord(&query, &updateQuery, &fingerprintQuery, record) == false)
+            {
+                return false;
+            }
+            seen.insert(record.path);
+            if(fingerprints.contains(record.path) == false || fingerprints.value(record.path).stamp != record.stamp)
+            {
+                rowsChanged++;
             }
             progress(progressCount++);
         }
     }
 
-    db.commit();
-    progress(100);
+    // whatever is left over has disappeared from disk
+    QHash<QString, Fingerprint>::const_iterator it;
+    for(it = fingerprints.constBegin(); it != fingerprints.constEnd(); ++it)
+    {
+        if(seen.contains(it.key()))
+        {
+            continue;
+        }
+
+        forgetQuery.bindValue(0, it.key());
+        if(forgetQuery.exec() == false)
+        {
+            return false;
+        }
+        rowsChanged++;
+    }
+    fingerprints.clear();
+
+    return deleteOrphans(deleteQuery) && saveEbuildCache(query);
+}
+
+// The -emerged and -hook paths after emerge merged or unmerged apps. /var/db/pkg is listed once per touched
+// category, INSTALLED and DOWNLOADSIZE are fixed up with a few set-based updates, and only packages that
+// gained a version without a PACKAGE row of its own get the full reloadPackages() treatment, all in one transaction.
+bool ImportVDB::emergedApps(QStringList appsList)
+{
+    rowsChanged = 0;
+
+    QMap<QString, QSet<QString>> touched;
+    QStringList sl;
+    foreach(const QString& app, appsList)
+    {
+        sl = app.split('/');
+        if(sl.count() == 2)
+        {
+            touched[sl.first()].insert(sl.last());
+        }
+    }
+
+    if(touched.isEmpty())
+    {
+        return true;
+    }
+
+    QSqlDatabase db;
+    if(QSqlDatabase::contains("RescanThread") == false)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE", "RescanThread");
+    }
+    else
+    {
+        db = QSqlDatabase::database("RescanThread");
+        if(db.isValid())
+        {
+            db.close();
+        }
+    }
+
+    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
+    db.open();
+    K9SqlFunctions::install(db);
+
+    QSqlQuery query(db);
+    QHash<QString, int> categoryIds;
+    if(query.exec("select CATEGORYID, CATEGORY from CATEGORY") == false)
+    {
+        return false;
+    }
+    while(query.next())
+    {
+        categoryIds.insert(query.value(1).toString(), query.value(0).toInt());
+    }
+
+    QMap<QString, QSet<QString>>::const_iterator it;
+    for(it = touched.constBegin(); it != touched.constEnd(); ++it)
+    {
+        if(categoryIds.contains(it.key()) == false)
+        {
+            // a brand new category needs a CATEGORY row, which only reloadDatabase() hands out
+            db.close();
+            loadConfig();
+            reloadDatabase();
+            return true;
+        }
+    }
+
+    db.transaction();
+    if(query.exec("create temp table if not exists EMERGED (CATEGORYID INTEGER, PACKAGE TEXT)") == false ||
+       query.exec("create temp table if not exists EMERGEDVERSION (CATEGORYID INTEGER, PACKAGE TEXT, VERSION TEXT, INSTALLED INTEGER, DOWNLOADSIZE INTEGER)") == false ||
+       query.exec("delete from EMERGED") == false || query.exec("delete from EMERGEDVERSION") == false)
+    {
+        db.rollback();
+        return false;
+    }
+
+    QSqlQuery emergedQuery(db);
+    QSqlQuery versionQuery(db);
+    emergedQuery.prepare("insert into EMERGED (CATEGORYID, PACKAGE) values(?, ?)");
+    versionQuery.prepare("insert into EMERGEDVERSION (CATEGORYID, PACKAGE, VERSION, INSTALLED, DOWNLOADSIZE) values(?, ?, ?, ?, ?)");
+
+    K9DirWalker dir;
+    VdbRecord vdb;
+    QRegularExpressionMatch match;
+    QString packageName;
+    QString size;
+    qint64 installed;
+    int downloadSize;
+    bool ok;
+    for(it = touched.constBegin(); it != touched.constEnd(); ++it)
+    {
+        const int categoryId = categoryIds.value(it.key());
+        const QSet<QString>& packages = it.value();
+        foreach(const QString& package, packages)
+        {
+            emergedQuery.bindValue(0, categoryId);
+            emergedQuery.bindValue(1, package);
+            if(emergedQuery.exec() == false)
+            {
+                db.rollback();
+                return false;
+            }
+        }
+
+        if(dir.open(portage->vdbFolder + it.key()) == false)
+        {
+            continue;
+        }
+
+        foreach(const QString& folder, dir.folders())
+        {
+            match = packageVersionRE.match(folder);
+            if(match.hasMatch() == false || packages.contains(packageName = match.captured(1)) == false)
+            {
+                continue;
+            }
+
+            if((installed = birthTime(dir.fd(), folder)) == -1)
+            {
+                continue;
+            }
+
+            downloadSize = -1;
+            if(vdb.open(dir.fd(), folder) && vdb.read("SIZE", size))
+            {
+                downloadSize = size.trimmed().toInt(&ok);
+                if(ok == false)
+                {
+                    downloadSize = -1;
+                }
+            }
+
+            versionQuery.bindValue(0, categoryId);
+            versionQuery.bindValue(1, packageName);
+            versionQuery.bindValue(2, match.captured(2));
+            versionQuery.bindValue(3, installed);
+            versionQuery.bindValue(4, downloadSize);
+            if(versionQuery.exec() == false)
+            {
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    {
+        K9Stats::Timer timer(stats, K9Stats::sql);
+
+        // freshly merged versions that already have a row
+        if(query.exec(QStringLiteral(R"EOF(
+update PACKAGE set
+    INSTALLED=(select e.INSTALLED from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION),
+    DOWNLOADSIZE=case when DOWNLOADSIZE=-1 then (select e.DOWNLOADSIZE from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION) else DOWNLOADSIZE end
+where INSTALLED=0 and exists (select 1 from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION)
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+        rowsChanged += query.numRowsAffected();
+
+        // unmerged versions the repos no longer carry disappear, the others just stop being installed
+        if(query.exec(QStringLiteral(R"EOF(
+delete from PACKAGEECLASS where PACKAGEID in
+(
+    select PACKAGEID from PACKAGE
+    where INSTALLED!=0 and OBSOLETED!=0
+    and exists (select 1 from EMERGED m where m.CATEGORYID=PACKAGE.CATEGORYID and m.PACKAGE=PACKAGE.PACKAGE)
+    and not exists (select 1 from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION)
+)
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+
+        if(query.exec(QStringLiteral(R"EOF(
+delete from PACKAGE
+where INSTALLED!=0 and OBSOLETED!=0
+and exists (select 1 from EMERGED m where m.CATEGORYID=PACKAGE.CATEGORYID and m.PACKAGE=PACKAGE.PACKAGE)
+and not exists (select 1 from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION)
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+        rowsChanged += query.numRowsAffected();
+
+        if(query.exec(QStringLiteral(R"EOF(
+update PACKAGE set INSTALLED=0
+where INSTALLED!=0 and OBSOLETED=0
+and exists (select 1 from EMERGED m where m.CATEGORYID=PACKAGE.CATEGORYID and m.PACKAGE=PACKAGE.PACKAGE)
+and not exists (select 1 from EMERGEDVERSION e where e.CATEGORYID=PACKAGE.CATEGORYID and e.PACKAGE=PACKAGE.PACKAGE and e.VERSION=PACKAGE.VERSION)
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+        rowsChanged += query.numRowsAffected();
+
+        // the stamps of these packages describe rows and VDB folders that just changed underneath
+        // them; without them the next incremental reload reads the packages again instead of skipping them
+        if(query.exec(QStringLiteral(R"EOF(
+delete from FINGERPRINT
+where exists (select 1 from EMERGED m where m.CATEGORYID=FINGERPRINT.CATEGORYID and m.PACKAGE=FINGERPRINT.PACKAGE)
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+
+        // installed versions with no row at all, e.g. merged from an ebuild that has since left the repo
+        if(query.exec(QStringLiteral(R"EOF(
+select distinct c.CATEGORY, e.PACKAGE
+from EMERGEDVERSION e join CATEGORY c on c.CATEGORYID=e.CATEGORYID
+where not exists (select 1 from PACKAGE p where p.CATEGORYID=e.CATEGORYID and p.PACKAGE=e.PACKAGE and p.VERSION=e.VERSION)
+order by c.CATEGORY, e.PACKAGE
+)EOF")) == false)
+        {
+            db.rollback();
+            return false;
+        }
+    }
+
+    QStringList reloadList;
+    while(query.next())
+    {
+        reloadList.append(QString("%1/%2").arg(query.value(0).toString(), query.value(1).toString()));
+    }
+
+    if(reloadList.isEmpty() == false)
+    {
+        loadConfig();
+        if(reloadPackages(db, reloadList) == false)
+        {
+            db.rollback();
+            return false;
+        }
+    }
+
+    db.commit();
+    return true;
+}
+
+// Packages merged or unmerged since the last time we looked, according to emerge.log, so a single
+// hook run after a world upgrade can pick them all up without being told.
+QStringList ImportVDB::emergeLogApps()
+{
+    QStringList apps;
+    QFile log(portage->emergeLog);
+    if(log.open(QIODevice::ReadOnly) == false)
+    {
+        output << "Can't open " << portage->emergeLog << Qt::endl;
+        return apps;
+    }
+
+    qint64 offset = 0;
+    QFile offsetFile(ds->storageFolder + emergeLogOffsetFileName);
+    if(offsetFile.open(QIODevice::ReadOnly))
+    {
+        offset = offsetFile.readAll().trimmed().toLongLong();
+        offsetFile.close();
+    }
+
+    if(offset > log.size())
+    {
+        // logrotate started a new file
+        offset = 0;
+    }
+    log.seek(offset);
+
+    QSet<QString> found;
+    QRegularExpressionMatch match;
+    QRegularExpressionMatch versionMatch;
+    QByteArray line;
+    while(log.atEnd() == false)
+    {
+        line = log.readLine();
+        if(line.endsWith('\n') == false)
+        {
+            // emerge is still writing this one, pick it up next time
+            break;
+        }
+        offset += line.size();
+
+        match = emergeLogRE.match(QString::fromUtf8(line));
+        if(match.hasMatch() == false)
+        {
+            continue;
+        }
+
+        versionMatch = packageVersionRE.match(match.captured(2));
+        if(versionMatch.hasMatch())
+        {
+            found.insert(QString("%1/%2").arg(match.captured(1), versionMatch.captured(1)));
+        }
+    }
+    log.close();
+
+    QSaveFile saveOffset(ds->storageFolder + emergeLogOffsetFileName);
+    if(saveOffset.open(QIODevice::WriteOnly))
+    {
+        saveOffset.write(QByteArray::number(offset));
+        saveOffset.commit();
+    }
+
+    apps = found.values();
+    apps.sort();
+    return apps;
 }
 
 int ImportVDB::readConfigFolder(/*QSqlQuery& query,*/ QString fileFolder)
@@ -527,6 +2319,7 @@ int ImportVDB::readProfileFolder(QString profileFolder)
 
     // read parent profiles first
     QString s = QString("%1/parent").arg(profileFolder);
+    addConfigStamp(s);
     QFileInfo fi;
     fi.setFile(s);
     if(fi.isFile())
@@ -570,6 +2363,7 @@ void ImportVDB::readMakeConf(QString filePath)
     QFile input;
     input.setFileName(filePath);
     QString varkey;
+    addConfigStamp(filePath);
     if(input.open(QIODevice::ReadOnly | QIODevice::Text))
     {
         QStringList lines = static_cast<QString>(input.readAll()).split('\n');
@@ -630,6 +2424,13 @@ void ImportVDB::readMakeConf(QString filePath)
 
 void ImportVDB::loadConfig()
 {
+    // the -reload and -emerged hooks run after every emerge, so skip re-parsing the profile stack when nothing in it changed
+    const QString profileFolder = QFileInfo(portage->configFolder + "make.profile").canonicalFilePath();
+    if(loadConfigCache(profileFolder))
+    {
+        return;
+    }
+
     QString s;
     QFileInfo fi;
     const int reposCount = portage->repos.count();
@@ -642,21 +2443,168 @@ void ImportVDB::loadConfig()
         }
     }
 
-    fi.setFile("/etc/portage/make.profile");
+    fi.setFile(portage->configFolder + "make.profile");
     if(fi.isDir())
     {
         readProfileFolder(fi.canonicalFilePath());
     }
 
-    s = QStringLiteral("/etc/portage");
+    s = portage->configFolder;
+    s.chop(1);
     if(readConfigFolder(s))
     {
         return;
     }
 
-    readMakeConf("/etc/portage/make.conf");
+    readMakeConf(portage->configFolder + "make.conf");
 
     profileFolders.clear();
+    saveConfigCache(profileFolder);
+}
+
+// Cached loadConfig() results are only good for the same profile, the same repos, and
+// config files that still have the paths, mtimes and sizes they had when they were read.
+bool ImportVDB::loadConfigCache(QString profileFolder)
+{
+    if(ds == nullptr)
+    {
+        return false;
+    }
+
+    QFile input(ds->storageFolder + configCacheFileName);
+    if(input.open(QIODevice::ReadOnly) == false)
+    {
+        return false;
+    }
+
+    QDataStream stream(&input);
+    stream.setVersion(QDataStream::Qt_5_12);
+
+    quint32 magic;
+    qint32 version;
+    QString cachedProfileFolder;
+    QStringList cachedRepos;
+    QStringList cachedFiles;
+    QStringList cachedStamps;
+    stream >> magic >> version;
+    if(magic != configCacheMagic || version != configCacheVersion)
+    {
+        return false;
+    }
+
+    stream >> cachedProfileFolder >> cachedRepos >> cachedFiles >> cachedStamps;
+    if(stream.status() != QDataStream::Ok || cachedProfileFolder != profileFolder || cachedRepos != portage->repos || cachedFiles.count() != cachedStamps.count())
+    {
+        return false;
+    }
+
+    const int fileCount = cachedFiles.count();
+    for(int i = 0; i < fileCount; i++)
+    {
+        if(configStamp(cachedFiles.at(i)) != cachedStamps.at(i))
+        {
+            return false;
+        }
+    }
+
+    QStringList cachedAtoms;
+    QHash<QString, QString> cachedMakeConf;
+    QHash<int, QList<K9AtomAction>> cachedActions;
+    qint32 atomCount;
+    qint32 actionCount;
+    qint32 atomId;
+    qint32 actionType;
+    K9AtomAction action;
+    stream >> cachedAtoms >> cachedMakeConf >> atomCount;
+    for(int i = 0; i < atomCount && stream.status() == QDataStream::Ok; i++)
+    {
+        stream >> atomId >> actionCount;
+        QList<K9AtomAction>& actions = cachedActions[atomId];
+        for(int j = 0; j < actionCount && stream.status() == QDataStream::Ok; j++)
+        {
+            stream >> actionType >> action.action;
+            action.actionType = static_cast<K9AtomAction::AtomActionType>(actionType);
+            actions.append(action);
+        }
+    }
+
+    if(stream.status() != QDataStream::Ok)
+    {
+        return false;
+    }
+
+    atoms = cachedAtoms;
+    atomList = K9AtomList();
+    const int atomsCount = atoms.count();
+    for(int i = 0; i < atomsCount; i++)
+    {
+        atomList.appendAtom(i, atoms.at(i));
+    }
+    atomList.atomActions = cachedActions;
+    makeConf = cachedMakeConf;
+    configFiles = cachedFiles;
+    configStamps = cachedStamps;
+    return true;
+}
+
+void ImportVDB::saveConfigCache(QString profileFolder)
+{
+    if(ds == nullptr)
+    {
+        return;
+    }
+
+    QSaveFile output(ds->storageFolder + configCacheFileName);
+    if(output.open(QIODevice::WriteOnly) == false)
+    {
+        return;
+    }
+
+    QDataStream stream(&output);
+    stream.setVersion(QDataStream::Qt_5_12);
+    stream << configCacheMagic << configCacheVersion;
+    stream << profileFolder << portage->repos << configFiles << configStamps;
+    stream << atoms << makeConf << static_cast<qint32>(atomList.atomActions.count());
+
+    QHash<int, QList<K9AtomAction>>::const_iterator it;
+    for(it = atomList.atomActions.constBegin(); it != atomList.atomActions.constEnd(); ++it)
+    {
+        const QList<K9AtomAction>& actions = it.value();
+        stream << static_cast<qint32>(it.key()) << static_cast<qint32>(actions.count());
+        foreach(const K9AtomAction& action, actions)
+        {
+            stream << static_cast<qint32>(action.actionType) << action.action;
+        }
+    }
+
+    if(stream.status() == QDataStream::Ok)
+    {
+        output.commit();
+    }
+}
+
+QString ImportVDB::configStamp(QString filePath)
+{
+    QFileInfo fi(filePath);
+    if(fi.exists())
+    {
+        return QString("%1 %2 %3").arg(filePath).arg(fi.lastModified().toMSecsSinceEpoch()).arg(fi.size());
+    }
+
+    // creating a config file that wasn't there before is a change too
+    return filePath;
+}
+
+void ImportVDB::addConfigStamp(QString filePath)
+{
+    configFiles.append(filePath);
+    configStamps.append(configStamp(filePath));
+}
+
+// Summarizes every config file loadConfig() looked at, so reloadDatabase() can tell when the masks need recomputing.
+QString ImportVDB::configSignature()
+{
+    return QString::fromLatin1(QCryptographicHash::hash(configStamps.join('\n').toUtf8(), QCryptographicHash::Md5).toHex());
 }
 
 int ImportVDB::readConfigFile(QString fileFolder, QString fileName, K9AtomAction::AtomActionType actionType)
@@ -665,6 +2613,7 @@ int ImportVDB::readConfigFile(QString fileFolder, QString fileName, K9AtomAction
     QString fileAndPath = QString("%1/%2").arg(fileFolder, fileName);
     QFileInfo fi;
     fi.setFile(fileAndPath);
+    addConfigStamp(fileAndPath);
     if(fi.isDir())
     {
         QDir dir;
@@ -799,9 +2748,9 @@ int ImportVDB::readConfigFile(QString fileFolder, QString fileName, K9AtomAction
     return 0;
 }
 
-void ImportVDB::applyConfigMasks(K9Atom::maskType& masked, QString category, QString package, QString slot, QString subslot, QStringList keywordList)
+void ImportVDB::applyConfigMasks(K9Atom::maskType& masked, QString category, QString package, QString slot, QString subslot, QStringList keywordList, const VersionString& version)
 {
-    QList<int> matchingAtomIds = atomList.findMatches(category, package, slot, subslot, portage->version);
+    QList<int> matchingAtomIds = atomList.findMatches(category, package, slot, subslot, version);
     const int matchingIdsCount = matchingAtomIds.count();
     int atomId;
     QStringList sl;
@@ -914,496 +2863,323 @@ void ImportVDB::applyConfigMasks(K9Atom::maskType& masked, QString category, QSt
     }
 }
 
-bool ImportVDB::importInstalledPackage(QSqlQuery* query, QString category, QString package)
+void ImportVDB::applyKeywordMasks(K9Atom::maskType& masked, qint64& status, const QStringList& keywordList)
+{
+    status = K9Portage::UNKNOWN;
+    masked = K9Atom::unsupportedMask;
+
+    if(keywordList.contains(QString("-%1").arg(portage->arch)) || keywordList.contains("-*"))
+    {
+        // package is broken for this architecture
+        status = K9Portage::UNKNOWN;
+        masked = K9Atom::brokenMask;
+    }
+
+    if(keywordList.contains(portage->arch))
+    {
+        status = K9Portage::STABLE;
+        masked = K9Atom::notMasked;
+    }
+    else if(keywordList.contains(QString("~%1").arg(portage->arch)))
+    {
+        status = K9Portage::TESTING;
+        masked = K9Atom::testingMask;
+    }
+}
+
+bool ImportVDB::importInstalledPackage(K9Ebuild& ebuild, VdbRecord& vdb, PackageRecord& record, int categoryFd, QString category, QString package)
 {
     QRegularExpressionMatch match;
-    QRegularExpression pvsplit;
-    pvsplit.setPattern("(.+)-([0-9][0-9,\\-,\\.,[A-z]*)");
 
-    QString categoryPath = QString("/var/db/pkg/%1/").arg(category);
     QString buildsPath;
     QString ebuildFilePath;
     QString data;
-    QString installedFilePath;
     QString metaCacheFilePath;
-    QString repoFilePath;
+    const K9MetaCache* metaCache = nullptr;
+    QString fileStamp;
     QString packageName;
     QString slot;
-    QString subslot;
-    int downloadSize = -1;
-    qint64 published = 0;
-    qint64 status = K9Portage::UNKNOWN;
-    QString keywords;
-    QString iuse;
-    QString license;
-    QString description;
-    QString homepage;
     QStringList keywordList;
-    qint64 installed = 0;
-    QFile input;
-    QFileInfo fi;
     bool ok;
     QString repo;
-    bool obsolete = true;
-    int repoId = 0;
-
-    portage->vars.clear();
-    portage->vars["PN"] = packageName = package;
-
-    match = pvsplit.match(package, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
-    if(match.hasMatch() && match.lastCapturedIndex() >= 2)
-    {
-        portage->vars["PN"] = packageName = match.captured(1);
-        portage->setVersion(match.captured(2));
-    }
-    else
-    {
-        portage->setVersion("0-0-0-0");
-    }
-
-    buildsPath = categoryPath;
-    buildsPath.append(package);
-    repoFilePath = QString("%1/repository").arg(buildsPath);
-    input.setFileName(repoFilePath);
-    if(!input.open(QIODevice::ReadOnly))
-    {
-        output << "Can't open repository file:" << input.fileName() << Qt::endl;
-        return true;
-    }
-
-    data = input.readAll();
-    input.close();
-    data = data.trimmed();
 
-    metaCacheFilePath = QString("/var/db/repos/%1/metadata/md5-cache/%2/%3-%4").arg(data, category, packageName, portage->version.pvr);
-    if(QFile::exists(metaCacheFilePath))
-    {
-        obsolete = false;
-        ebuildFilePath = metaCacheFilePath;
-    }
-    else
     {
-        installedFilePath = QString("/var/db/repos/%1/%2/%3/%3-%4.ebuild").arg(data, category, packageName, portage->version.pvr);
-        if(QFile::exists(installedFilePath))
+        K9Stats::Timer timer(stats, K9Stats::parse, -1);
+        match = packageVersionRE.match(package, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
+        if(match.hasMatch() && match.lastCapturedIndex() >= 2)
         {
-            obsolete = false;
-            ebuildFilePath = installedFilePath;
+            packageName = match.captured(1);
+            ebuild.setPackage(packageName, match.captured(2));
         }
         else
         {
-            ebuildFilePath = QString("%1/%2.ebuild").arg(buildsPath, package);
+            packageName = package;
+            ebuild.setPackage(packageName, "0-0-0-0");
         }
     }
 
-    fi.setFile(ebuildFilePath);
-    installed = fi.birthTime().toSecsSinceEpoch();
-    published = 0;
-
-    portage->ebuildReader(ebuildFilePath);
-
-    repo = QString("/var/db/repos/%1/").arg(data);
-    repoId = -1;
-    for(int i = 0; i < portage->repos.count(); i++)
+    buildsPath = portage->vdbFolder + category + '/' + package;
+    record.path = buildsPath;
+    record.package = packageName;
+    K9Stats::Timer readTimer(stats, K9Stats::read, -1);
+    if(vdb.open(categoryFd, package) == false || vdb.read("repository", data) == false)
     {
-        if(repo == portage->repos.at(i))
+        readTimer.stop();
+        QMutexLocker lock(&outputMutex);
+        output << "Can't open repository file:" << buildsPath << "/repository" << Qt::endl;
+        return false;
+    }
+    record.stamp = QString::number(vdb.modified());
+
+    // Everything portage recorded at merge time. Files are only written for non-empty values.
+    QString vdbDescription, vdbHomepage, vdbKeywords, vdbIuse, vdbSlot, vdbLicense, vdbSize;
+    const bool hasDescription = vdb.read("DESCRIPTION", vdbDescription);
+    const bool hasHomepage = vdb.read("HOMEPAGE", vdbHomepage);
+    const bool hasKeywords = vdb.read("KEYWORDS", vdbKeywords);
+    const bool hasIuse = vdb.read("IUSE", vdbIuse);
+    const bool hasSlot = vdb.read("SLOT", vdbSlot);
+    const bool hasLicense = vdb.read("LICENSE", vdbLicense);
+    const bool hasSize = vdb.read("SIZE", vdbSize);
+    readTimer.stop();
+
+    record.obsoleted = true;
+    record.published = 0;
+    repo = portage->repoFolder + data + '/';
+    metaCacheFilePath = repo + QStringLiteral("metadata/md5-cache/") + category + '/' + packageName + '-' + ebuild.version.pvr;
+    ebuildFilePath = repo + category + '/' + packageName + '/' + packageName + '-' + ebuild.version.pvr + QStringLiteral(".ebuild");
+    if((record.installed = birthTime(AT_FDCWD, metaCacheFilePath)) != -1)
+    {
+        // KEYWORDS and IUSE come from the repo, which may have stabilized what we installed during testing
+        record.obsoleted = false;
+        K9Stats::Timer timer(stats, K9Stats::parse, -1);
+        if(ebuild.metaCache.read(metaCacheFilePath))
         {
-            repoId = i;
-            break;
+            metaCache = &ebuild.metaCache;
         }
     }
-
-    description = portage->var("DESCRIPTION").toString();
-    input.setFileName(QString("%1/DESCRIPTION").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
-    {
-        data = input.readAll();
-        input.close();
-        description = data.trimmed();
-    }
-
-    homepage = portage->var("HOMEPAGE").toString();
-    input.setFileName(QString("%1/HOMEPAGE").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
+    else if((record.installed = birthTime(AT_FDCWD, ebuildFilePath, &fileStamp)) != -1)
     {
-        data = input.readAll();
-        input.close();
-        homepage = data.trimmed();
+        record.obsoleted = false;
+        K9Stats::Timer timer(stats, K9Stats::parse, -1);
+        readEbuild(ebuild, ebuildFilePath, fileStamp);
     }
-
-    downloadSize = -1;
-    input.setFileName(QString("%1/SIZE").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
+    else
     {
-        data = input.readAll();
-        input.close();
-        data = data.trimmed();
-        downloadSize = data.toInt(&ok);
-        if(ok == false)
+        // no longer in any repo, so the copy of the ebuild in /var/db/pkg is only needed for values the VDB didn't record
+        ebuildFilePath = package + QStringLiteral(".ebuild");
+        record.installed = qMax(birthTime(vdb.fd(), ebuildFilePath), Q_INT64_C(0));
+        if((hasDescription && hasHomepage && hasKeywords && hasIuse && hasSlot && hasLicense) == false)
         {
-            downloadSize = -1;
+            K9Stats::Timer timer(stats, K9Stats::parse, -1);
+            ebuild.ebuildReader(buildsPath + '/' + ebuildFilePath);
         }
     }
 
-    keywords = portage->var("KEYWORDS").toString();
-    if(keywords.isEmpty()) // don't override the metaCache data for KEYWORDS -- repo may have marked stable something we previously installed during testing.
+    // md5-cache values when we have them, otherwise whatever the ebuild reader found
+    auto ebuildValue = [&ebuild, metaCache](K9Metadata::Key key)
+    {
+        return metaCache ? metaCache->value(key) : ebuild.metadata.value(key);
+    };
+
+    int repoIndex = portage->repos.indexOf(repo);
+    record.repoId = (repoIndex == -1) ? -1 : repoIds.value(repoIndex, -1);
+
+    record.description = hasDescription ? vdbDescription : ebuildValue(K9Metadata::description);
+    record.homepage = hasHomepage ? vdbHomepage : ebuildValue(K9Metadata::homepage);
+
+    record.downloadSize = -1;
+    if(hasSize)
     {
-        input.setFileName(QString("%1/KEYWORDS").arg(buildsPath));
-        if(input.open(QIODevice::ReadOnly))
+        record.downloadSize = vdbSize.toInt(&ok);
+        if(ok == false)
         {
-            data = input.readAll();
-            input.close();
-            keywords = data.trimmed();
+            record.downloadSize = -1;
         }
     }
-    K9Atom::maskType masked;
-    status = K9Portage::UNKNOWN;
-    masked = K9Atom::unsupportedMask;
 
-    keywordList = keywords.split(' ');
-    if(keywordList.contains(QString("-%1").arg(portage->arch)) || keywordList.contains("-*"))
+    record.keywords = ebuildValue(K9Metadata::keywords);
+    if(record.keywords.isEmpty()) // don't override the metaCache data for KEYWORDS -- repo may have marked stable something we previously installed during testing.
     {
-        // package is broken for this architecture
-        status = K9Portage::UNKNOWN;
-        masked = K9Atom::brokenMask;
+        record.keywords = vdbKeywords;
     }
 
-    if(keywordList.contains(portage->arch))
-    {
-        status = K9Portage::STABLE;
-        masked = K9Atom::notMasked;
-    }
-    else if(keywordList.contains(QString("~%1").arg(portage->arch)))
+    K9Atom::maskType masked;
+    keywordList = record.keywords.split(' ');
     {
-        status = K9Portage::TESTING;
-        masked = K9Atom::testingMask;
+        K9Stats::Timer timer(stats, K9Stats::masks, -1);
+        applyKeywordMasks(masked, record.status, keywordList);
     }
 
-    iuse = portage->var("IUSE").toString();
-    if(iuse.isEmpty())
+    record.iuse = ebuildValue(K9Metadata::iuse);
+    if(record.iuse.isEmpty())
     {
-        input.setFileName(QString("%1/IUSE").arg(buildsPath));
-        if(input.open(QIODevice::ReadOnly))
-        {
-            data = input.readAll();
-            input.close();
-            iuse = data.trimmed();
-        }
+        record.iuse = vdbIuse;
     }
 
-    if(repoId == -1)
+    slot = hasSlot ? vdbSlot : ebuildValue(K9Metadata::slot);
+    if(slot.contains('/'))
     {
-#if QT_VERSION < 0x060000
-        query->bindValue(1, QVariant(QVariant::Int)); // NULL repoId
-#else
-        query->bindValue(1, QVariant(QMetaType::fromType<int>())); // NULL repoId
-#endif
+        int ix = slot.indexOf('/');
+        record.subslot = slot.mid(ix + 1);
+        record.slot = slot.left(ix);
     }
     else
     {
-        query->bindValue(1, repoId);
+        record.slot = slot;
+        record.subslot.clear();
     }
 
-    slot = portage->var("SLOT").toString();
-    input.setFileName(QString("%1/SLOT").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
-    {
-        data = input.readAll();
-        input.close();
-        slot = data.trimmed();
-    }
-    if(slot.contains('/'))
+    record.license = hasLicense ? vdbLicense : ebuildValue(K9Metadata::license);
+
+    // a rebuild inherits whatever the repo's ebuild does now; the VDB's list is what this version was built with
+    if(metaCache)
     {
-        int ix = slot.indexOf('/');
-        subslot = slot.mid(ix + 1);
-        slot = slot.left(ix);
+        record.eclasses = eclassNames(*metaCache);
+        record.inherit = metaCache->value(K9Metadata::inherit);
     }
     else
     {
-        subslot.clear();
+        vdb.read("INHERITED", record.eclasses);
     }
 
-    license = portage->var("LICENSE").toString();
-    input.setFileName(QString("%1/LICENSE").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
     {
-        data = input.readAll();
-        input.close();
-        license = data.trimmed();
-    }
-
-    applyConfigMasks(masked, category, packageName, slot, subslot, keywordList);
-
-    query->bindValue(2, packageName);
-    query->bindValue(3, description);
-    query->bindValue(4, homepage);
-    query->bindValue(5, portage->version.pvr);
-    query->bindValue(6, QVariant(slot));
-    query->bindValue(7, license);
-    query->bindValue(8, installed);
-    query->bindValue(9, obsolete);
-    query->bindValue(10, downloadSize);
-    query->bindValue(11, keywords);
-    query->bindValue(12, iuse);
-    query->bindValue(13, masked);
-    query->bindValue(14, published);
-    query->bindValue(15, status);
-    query->bindValue(16, QVariant(subslot));
-    query->bindValue(17, portage->version.cutInternalVx(0));
-    query->bindValue(18, portage->version.cutInternalVx(1));
-    query->bindValue(19, portage->version.cutInternalVx(2));
-    query->bindValue(20, portage->version.cutInternalVx(3));
-    query->bindValue(21, portage->version.cutInternalVx(4));
-    query->bindValue(22, portage->version.cutInternalVx(5));
-    query->bindValue(23, portage->version.cutInternalVx(6));
-    query->bindValue(24, portage->version.cutInternalVx(7));
-    query->bindValue(25, portage->version.cutInternalVx(8));
-    query->bindValue(26, portage->version.revision());
-    if(query->exec() == false)
+        K9Stats::Timer timer(stats, K9Stats::masks, -1);
+        applyConfigMasks(masked, category, packageName, record.slot, record.subslot, keywordList, ebuild.version);
+    }
+
+    record.package = packageName;
+    record.version = ebuild.version.pvr;
+    record.masked = masked;
+    for(int i = 0; i < MAXVX - 1; i++)
     {
-        return false;
+        record.vx[i] = ebuild.version.cutInternalVx(i);
     }
+    record.vx[MAXVX - 1] = ebuild.version.revision();
+    record.versionKey = ebuild.version.sortKey();
 
+    vdb.close();
     return true;
 }
 
-bool ImportVDB::importRepoPackage(QSqlQuery* query, QString category, QString packageName, QString buildsPath, QString ebuildFilePath)
+bool ImportVDB::importRepoPackage(K9Ebuild& ebuild, PackageRecord& record, QString category, QString packageName, QString ebuildFileName, QString fileStamp)
 {
-    QRegularExpressionMatch match;
-    QRegularExpression pvsplit;
-    pvsplit.setPattern("(.+)-([0-9][0-9,\\-,\\.,[A-z]*)");
-
-    QString installedFilePath;
     QString slot;
-    QString subslot;
-    int downloadSize;
-    qint64 published = 0;
-    qint64 status = K9Portage::UNKNOWN;
-    QString keywords;
     QStringList keywordList;
-    qint64 installed = 0;
-    QFileInfo fi;
-    QFile input;
-    QString data;
-    bool ok;
-
-    portage->vars.clear();
-    portage->vars["PN"] = packageName;
-    portage->setVersion(ebuildFilePath.mid(packageName.length() + 1, ebuildFilePath.length() - (7 + packageName.length() + 1)));
 
-    installed = 0;
-    installedFilePath = QString("/var/db/pkg/%1/%2-%3").arg(category, packageName, portage->version.pvr);
-    fi.setFile(installedFilePath);
-    if(fi.exists())
+    const int source = repoIds.indexOf(record.repoId);
     {
-        return true;
+        K9Stats::Timer timer(stats, K9Stats::parse, source);
+        ebuild.setPackage(packageName, ebuildFileName.mid(packageName.length() + 1, ebuildFileName.length() - (7 + packageName.length() + 1)));
+        readEbuild(ebuild, record.path, fileStamp);
     }
 
-    fi.setFile(buildsPath + "/" + ebuildFilePath);
-    published = fi.birthTime().toSecsSinceEpoch();
-
-    portage->ebuildReader(buildsPath + "/" + ebuildFilePath);
-
-    downloadSize = -1;
-    input.setFileName(QString("%1/SIZE").arg(buildsPath));
-    if(input.open(QIODevice::ReadOnly))
-    {
-        data = input.readAll();
-        input.close();
-        data = data.trimmed();
-        downloadSize = data.toInt(&ok);
-        if(ok == false)
-        {
-            downloadSize = -1;
-        }
-    }
+    // packages that aren't installed have no /var/db/pkg/.../SIZE file to read the download size from
+    record.downloadSize = -1;
 
-    keywords = portage->var("KEYWORDS").toString();
+    record.keywords = ebuild.metadata.value(K9Metadata::keywords);
     K9Atom::maskType masked;
-    status = K9Portage::UNKNOWN;
-    masked = K9Atom::unsupportedMask;
-
-    keywordList = keywords.split(' ');
-    if(keywordList.contains(QString("-%1").arg(portage->arch)) || keywordList.contains("-*"))
+    keywordList = record.keywords.split(' ');
     {
-        // package is broken for this architecture
-        status = K9Portage::UNKNOWN;
-        masked = K9Atom::brokenMask;
+        K9Stats::Timer timer(stats, K9Stats::masks, source);
+        applyKeywordMasks(masked, record.status, keywordList);
     }
 
-    if(keywordList.contains(portage->arch))
+    slot = ebuild.metadata.value(K9Metadata::slot);
+    if(slot.contains('/'))
     {
-        status = K9Portage::STABLE;
-        masked = K9Atom::notMasked;
+        int ix = slot.indexOf('/');
+        record.subslot = slot.mid(ix + 1);
+        record.slot = slot.left(ix);
     }
-    else if(keywordList.contains(QString("~%1").arg(portage->arch)))
+    else
     {
-        status = K9Portage::TESTING;
-        masked = K9Atom::testingMask;
+        record.slot = slot;
+        record.subslot.clear();
     }
 
-
-
-    slot = portage->var("SLOT").toString();
-    if(slot.contains('/'))
     {
-        int ix = slot.indexOf('/');
-        subslot = slot.mid(ix + 1);
-        slot = slot.left(ix);
+        K9Stats::Timer timer(stats, K9Stats::masks, source);
+        applyConfigMasks(masked, category, packageName, record.slot, record.subslot, keywordList, ebuild.version);
     }
-    else
-    {
-        subslot.clear();
-    }
-
-    applyConfigMasks(masked, category, packageName, slot, subslot, keywordList);
-
-    query->bindValue(2, packageName);
-    query->bindValue(3, portage->var("DESCRIPTION"));
-    query->bindValue(4, portage->var("HOMEPAGE"));
-    query->bindValue(5, portage->version.pvr);
-    query->bindValue(6, QVariant(slot));
-    query->bindValue(7, portage->var("LICENSE"));
-    query->bindValue(8, installed);
-    query->bindValue(9, 0); /* not obsolete if repo still has .ebuild file */
-    query->bindValue(10, downloadSize);
-    query->bindValue(11, keywords);
-    query->bindValue(12, portage->var("IUSE"));
-    query->bindValue(13, masked);
-    query->bindValue(14, published);
-    query->bindValue(15, status);
-    query->bindValue(16, QVariant(subslot));
-    query->bindValue(17, portage->version.cutInternalVx(0));
-    query->bindValue(18, portage->version.cutInternalVx(1));
-    query->bindValue(19, portage->version.cutInternalVx(2));
-    query->bindValue(20, portage->version.cutInternalVx(3));
-    query->bindValue(21, portage->version.cutInternalVx(4));
-    query->bindValue(22, portage->version.cutInternalVx(5));
-    query->bindValue(23, portage->version.cutInternalVx(6));
-    query->bindValue(24, portage->version.cutInternalVx(7));
-    query->bindValue(25, portage->version.cutInternalVx(8));
-    query->bindValue(26, portage->version.revision());
-    if(query->exec() == false)
+
+    record.package = packageName;
+    record.description = ebuild.metadata.value(K9Metadata::description);
+    record.homepage = ebuild.metadata.value(K9Metadata::homepage);
+    record.version = ebuild.version.pvr;
+    record.license = ebuild.metadata.value(K9Metadata::license);
+    record.installed = 0;
+    record.obsoleted = false; /* not obsolete if repo still has .ebuild file */
+    record.iuse = ebuild.metadata.value(K9Metadata::iuse);
+    record.masked = masked;
+    for(int i = 0; i < MAXVX - 1; i++)
     {
-        return false;
+        record.vx[i] = ebuild.version.cutInternalVx(i);
     }
+    record.vx[MAXVX - 1] = ebuild.version.revision();
+    record.versionKey = ebuild.version.sortKey();
 
     return true;
 }
 
-bool ImportVDB::importMetaCache(QSqlQuery* query, QString category, QString packageName, QString metaCacheFilePath, QString version)
+// The md5-cache entry was already read into ebuild.metaCache by importEbuild() to compute its stamp.
+bool ImportVDB::importMetaCache(K9Ebuild& ebuild, PackageRecord& record, QString category, QString packageName, QString version)
 {
-    QRegularExpressionMatch match;
-    QRegularExpression pvsplit;
-    pvsplit.setPattern("(.+)-([0-9][0-9,\\-,\\.,[A-z]*)");
-
-    QString installedFilePath;
     QString slot;
-    QString subslot;
-    int downloadSize;
-    qint64 status = K9Portage::UNKNOWN;
-    QString keywords;
     QStringList keywordList;
-    qint64 installed = 0;
-    QFileInfo fi;
-    QFile input;
-    QString data;
-    bool ok;
-
-    portage->vars.clear();
-    portage->vars["PN"] = packageName;
-    portage->setVersion(version);
-
-    installed = 0;
-    installedFilePath = QString("/var/db/pkg/%1/%2-%3").arg(category, packageName, portage->version.pvr);
-    fi.setFile(installedFilePath);
-    if(fi.exists())
-    {
-        return true;
-    }
 
-    portage->md5cacheReader(metaCacheFilePath);
-
-    downloadSize = -1;
-    input.setFileName(QString("/var/db/pkg/%1/%2-%3/SIZE").arg(category, packageName, portage->version.pvr));
-    if(input.open(QIODevice::ReadOnly))
+    const int source = repoIds.indexOf(record.repoId);
     {
-        data = input.readAll();
-        input.close();
-        data = data.trimmed();
-        downloadSize = data.toInt(&ok);
-        if(ok == false)
-        {
-            downloadSize = -1;
-        }
+        K9Stats::Timer timer(stats, K9Stats::parse, source);
+        ebuild.setPackage(packageName, version);
     }
+    const K9MetaCache& metaCache = ebuild.metaCache;
 
-    keywords = portage->var("KEYWORDS").toString();
+    // packages that aren't installed have no /var/db/pkg/.../SIZE file to read the download size from
+    record.downloadSize = -1;
 
+    record.keywords = metaCache.value(K9Metadata::keywords);
+    record.eclasses = eclassNames(metaCache);
+    record.inherit = metaCache.value(K9Metadata::inherit);
     K9Atom::maskType masked;
-    status = K9Portage::UNKNOWN;
-    masked = K9Atom::unsupportedMask;
-
-    keywordList = keywords.split(' ');
-    if(keywordList.contains(QString("-%1").arg(portage->arch)) || keywordList.contains("-*"))
+    keywordList = record.keywords.split(' ');
     {
-        // package is broken for this architecture
-        status = K9Portage::UNKNOWN;
-        masked = K9Atom::brokenMask;
+        K9Stats::Timer timer(stats, K9Stats::masks, source);
+        applyKeywordMasks(masked, record.status, keywordList);
     }
 
-    if(keywordList.contains(portage->arch))
+    slot = metaCache.value(K9Metadata::slot);
+    if(slot.contains('/'))
     {
-        status = K9Portage::STABLE;
-        masked = K9Atom::notMasked;
+        int ix = slot.indexOf('/');
+        record.subslot = slot.mid(ix + 1);
+        record.slot = slot.left(ix);
     }
-    else if(keywordList.contains(QString("~%1").arg(portage->arch)))
+    else
     {
-        status = K9Portage::TESTING;
-        masked = K9Atom::testingMask;
+        record.slot = slot;
+        record.subslot.clear();
     }
 
-    slot = portage->var("SLOT").toString();
-    if(slot.contains('/'))
     {
-        int ix = slot.indexOf('/');
-        subslot = slot.mid(ix + 1);
-        slot = slot.left(ix);
+        K9Stats::Timer timer(stats, K9Stats::masks, source);
+        applyConfigMasks(masked, category, packageName, record.slot, record.subslot, keywordList, ebuild.version);
     }
-    else
-    {
-        subslot.clear();
-    }
-
-    applyConfigMasks(masked, category, packageName, slot, subslot, keywordList);
-
-    query->bindValue(2, packageName);
-    query->bindValue(3, portage->var("DESCRIPTION"));
-    query->bindValue(4, portage->var("HOMEPAGE"));
-    query->bindValue(5, portage->version.pvr);
-    query->bindValue(6, QVariant(slot));
-    query->bindValue(7, portage->var("LICENSE"));
-    query->bindValue(8, installed);
-    query->bindValue(9, 0); /* not obsolete if repo still has .ebuild file */
-    query->bindValue(10, downloadSize);
-    query->bindValue(11, keywords);
-    query->bindValue(12, portage->var("IUSE"));
-    query->bindValue(13, masked);
-    query->bindValue(15, status);
-    query->bindValue(16, QVariant(subslot));
-    query->bindValue(17, portage->version.cutInternalVx(0));
-    query->bindValue(18, portage->version.cutInternalVx(1));
-    query->bindValue(19, portage->version.cutInternalVx(2));
-    query->bindValue(20, portage->version.cutInternalVx(3));
-    query->bindValue(21, portage->version.cutInternalVx(4));
-    query->bindValue(22, portage->version.cutInternalVx(5));
-    query->bindValue(23, portage->version.cutInternalVx(6));
-    query->bindValue(24, portage->version.cutInternalVx(7));
-    query->bindValue(25, portage->version.cutInternalVx(8));
-    query->bindValue(26, portage->version.revision());
-    if(query->exec() == false)
+
+    record.package = packageName;
+    record.description = metaCache.value(K9Metadata::description);
+    record.homepage = metaCache.value(K9Metadata::homepage);
+    record.version = ebuild.version.pvr;
+    record.license = metaCache.value(K9Metadata::license);
+    record.installed = 0;
+    record.obsoleted = false; /* not obsolete if repo still has .ebuild file */
+    record.iuse = metaCache.value(K9Metadata::iuse);
+    record.masked = masked;
+    for(int i = 0; i < MAXVX - 1; i++)
     {
-        return false;
+        record.vx[i] = ebuild.version.cutInternalVx(i);
     }
+    record.vx[MAXVX - 1] = ebuild.version.revision();
+    record.versionKey = ebuild.version.sortKey();
 
     return true;
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2021-2023, K9spud LLC.
+// Copyright (c) 2021-2026, K9spud LLC.
 //
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -18,33 +18,172 @@
 #define IMPORTVDB_H
 
 #include "k9atomlist.h"
+#include "k9eclassindex.h"
+#include "k9metadata.h"
+#include "k9sidetables.h"
+#include "versionstring.h"
 
 #include <QStringList>
+#include <QList>
+#include <QHash>
+#include <QSet>
+#include <QMutex>
+#include <QWaitCondition>
 
 class QSqlQuery;
+class QSqlDatabase;
+class QThreadPool;
+class K9Ebuild;
+class VdbRecord;
+class K9Stats;
+class K9MetaCache;
 class ImportVDB
 {
 public:
     ImportVDB();
     bool abort;
+    int jobs; // number of worker threads parsing package folders during reloadDatabase()
+    bool fullReload; // ignore FINGERPRINT and re-import every ebuild
+    bool shadow; // rebuild a copy of the database and rename it over the live one when done
+    int rowsChanged; // ebuilds added, changed or removed by the last reloadDatabase() or reloadApp()
+    K9Stats* stats; // per-phase timings for -stats, null when nobody asked
+
+    // One PACKAGE table row. Filled in by the import workers and handed off to the database writer.
+    struct PackageRecord
+    {
+        int categoryId = -1;
+        int repoId = -1;
+        QString package;
+        QString description;
+        QString homepage;
+        QString version;
+        QString slot;
+        QString subslot;
+        QString license;
+        qint64 installed = 0;
+        bool obsoleted = false;
+        int downloadSize = -1;
+        QString keywords;
+        QString iuse;
+        QString eclasses; // every eclass the ebuild inherits, directly or through another eclass, separated by spaces
+        QString inherit; // the eclasses the ebuild's own inherit line names
+        int masked = 0;
+        qint64 published = 0;
+        qint64 status = 0;
+        QString vx[MAXVX];
+        QByteArray versionKey; // VersionString::sortKey()
+
+        QString path; // ebuild (or /var/db/pkg folder) this row was parsed from
+        QString stamp; // FINGERPRINT.STAMP of path at the time it was parsed
+        bool unchanged = false; // stamp matched FINGERPRINT, so the existing row was kept
+        bool hasRow = true; // false when the ebuild is fingerprinted but has no row of its own (it's installed)
+    };
+
+    // One FINGERPRINT table row, as it was before this reload started.
+    struct Fingerprint
+    {
+        QString stamp;
+        qint64 packageId = -1;
+    };
+
+    // The variables importRepoPackage() and importInstalledPackage() use from a parsed ebuild, as stored in EBUILDCACHE.
+    static const int ebuildCacheVarCount = K9Metadata::ebuildKeyCount;
+    struct EbuildCacheEntry
+    {
+        QString stamp; // mtime:size of the ebuild when it was parsed
+        QString values[ebuildCacheVarCount]; // DESCRIPTION, HOMEPAGE, SLOT, KEYWORDS, IUSE, LICENSE, in K9Metadata::Key order
+    };
+
+    // The columns of a PACKAGE row that MASKED and STATUS are computed from.
+    struct MaskRow
+    {
+        qint64 packageId = -1;
+        QString category;
+        QString package;
+        QString version;
+        QString slot;
+        QString subslot;
+        QString keywords;
+        int masked = 0;
+        qint64 status = 0;
+        bool changed = false; // masked or status differ from what the row had
+    };
+
+    // Directory listings shared by every ebuild in a category, so importEbuild() can look
+    // files up in memory instead of stat()ing each one.
+    struct CategoryListing
+    {
+        QSet<QString> metaCache; // md5-cache entries (PF) of the repo being imported
+        QSet<QString> installed; // /var/db/pkg entries (PF)
+    };
 
     QStringList atoms; // allows for looking up atomId given a full atom filter string
     K9AtomList atomList; // allows for looking up parsed K9Atom objects and their configuration, using full atom filter matching
     QHash<QString, QString> makeConf; // contains /etc/portage/make.conf style environment variable settings
+    QStringList categories; // CATEGORYID is the index into this list
+    QList<int> repoIds; // REPOID of each portage->repos entry
+    QStringList repoCommits; // REPO.HEADCOMMIT of each portage->repos entry, empty when it isn't a git checkout
+    QHash<int, QSet<QString>> deltaPackages; // "category/package" folders changed since the last indexed commit, keyed by portage->repos index
+    QHash<QString, Fingerprint> fingerprints; // FINGERPRINT rows keyed by PATH, read-only while import workers are running
+    bool reimportAll; // parse every ebuild even when its fingerprint matches; rows are still diffed, not replaced
+    QHash<QString, qint64> packageIds; // existing PACKAGEIDs keyed by repo, category, package and version, so rewritten rows keep their id
+    QSet<qint64> orphans; // rows whose ebuild changed or vanished, deleted by deleteOrphans() unless some record claimed them
+    QSet<qint64> claimed; // rows written or kept unchanged during this reload
+    K9SideTables sideTables; // ids of the DESCRIPTION, HOMEPAGE, KEYWORDS, IUSE and LICENSE strings PACKAGE refers to
+    K9EclassIndex eclassIndex; // ECLASS ids and the PACKAGEECLASS rows of each PACKAGE row written
+    QHash<QString, EbuildCacheEntry> ebuildCache; // EBUILDCACHE rows keyed by PATH, read-only while import workers are running
+    QHash<QString, EbuildCacheEntry> freshEbuildCache; // ebuilds parsed during this reload, waiting to be written to EBUILDCACHE
+    QStringList configFiles; // every config file loadConfig() looked at
+    QStringList configStamps; // path, mtime and size of every config file loadConfig() looked at
 
     void loadConfig(void);
     void readMakeConf(QString filePath);
     int readConfigFolder(QString fileFolder);
     int readProfileFolder(QString profileFolder);
     int readConfigFile(QString fileFolder, QString fileName, K9AtomAction::AtomActionType actionType);
-    void applyConfigMasks(K9Atom::maskType& masked, QString category, QString package, QString slot, QString subslot, QStringList keywordList);
+    void applyConfigMasks(K9Atom::maskType& masked, QString category, QString package, QString slot, QString subslot, QStringList keywordList, const VersionString& version);
+    void applyKeywordMasks(K9Atom::maskType& masked, qint64& status, const QStringList& keywordList);
+    QString configStamp(QString filePath);
+    void addConfigStamp(QString filePath);
+    bool loadConfigCache(QString profileFolder);
+    void saveConfigCache(QString profileFolder);
+    QString configSignature(void);
 
     void reloadDatabase(void);
+    bool importDatabase(QSqlDatabase& db);
+    bool createShadowDatabase(QString livePath, QString shadowPath);
+    bool swapShadowDatabase(QSqlDatabase& db, QString livePath, QString shadowPath, QStringList& changedApps);
     void reloadApp(QStringList appsList);
+    bool reloadPackages(QSqlDatabase& db, const QStringList& appsList);
+    bool emergedApps(QStringList appsList);
+    QStringList emergeLogApps(void);
+    bool remaskDatabase(void);
+    bool remaskPackages(QSqlDatabase& db);
+    void remaskRow(MaskRow& row);
 
-    bool importInstalledPackage(QSqlQuery* insertQuery, QString category, QString packagePath);
-    bool importRepoPackage(QSqlQuery* insertQuery, QString category, QString packageName, QString buildsPath, QString ebuildFilePath);
-    bool importMetaCache(QSqlQuery* insertQuery, QString category, QString packageName, QString metaCacheFilePath, QString version);
+    void importCategory(K9Ebuild& ebuild, QList<PackageRecord>& records, int repoIndex, int categoryId, const QStringList& packages);
+    void loadCategoryListing(CategoryListing& listing, int repoIndex, QString category);
+    void importEbuild(K9Ebuild& ebuild, PackageRecord& record, const CategoryListing& listing, int packageFd, int repoIndex, QString category, QString packageName, QString ebuildFileName);
+    void importInstalledCategory(K9Ebuild& ebuild, QList<PackageRecord>& records, int categoryId);
+    void queueRecords(const QList<PackageRecord>& records);
+    bool writeQueuedRecords(QSqlDatabase& db, QThreadPool& pool, int taskCount);
+    bool writeRecord(QSqlQuery* insertQuery, QSqlQuery* updateQuery, QSqlQuery* fingerprintQuery, const PackageRecord& record);
+    bool insertPackage(QSqlQuery* insertQuery, const PackageRecord& record);
+    bool bindPackage(QSqlQuery* query, const PackageRecord& record, int first);
+    bool loadPackageIds(QSqlQuery& query, bool orphaned);
+    bool deleteOrphans(QSqlQuery& deleteQuery);
+    bool loadRepos(QSqlQuery& query);
+    QString gitHead(QString repoFolder);
+    bool gitChangedPackages(QString repoFolder, QString fromCommit, QString toCommit, QSet<QString>& packages);
+    bool skippedByDelta(const QString& path);
+    bool loadEbuildCache(QSqlQuery& query);
+    bool saveEbuildCache(QSqlQuery& query);
+    void readEbuild(K9Ebuild& ebuild, const QString& ebuildPath, const QString& stamp);
+    QString ebuildStamp(const K9MetaCache* metaCache, qint64 modified, qint64 size, bool installed);
+
+    bool importInstalledPackage(K9Ebuild& ebuild, VdbRecord& vdb, PackageRecord& record, int categoryFd, QString category, QString packagePath);
+    bool importRepoPackage(K9Ebuild& ebuild, PackageRecord& record, QString category, QString packageName, QString ebuildFileName, QString fileStamp);
+    bool importMetaCache(K9Ebuild& ebuild, PackageRecord& record, QString category, QString packageName, QString version);
 
     int loadCategories(QStringList& categories, const QString folder);
 
@@ -52,6 +191,11 @@ protected:
 
 private:
     QStringList profileFolders; // used to keep track of which profile folders we've already loaded so we don't get into an infinite loop
+
+    QMutex ebuildCacheMutex; // guards freshEbuildCache
+    QMutex queueMutex;
+    QWaitCondition queueReady;
+    QList<QList<PackageRecord>> queue; // parsed records waiting for the database writer
 };
 
 #endif // IMPORTVDB_H
@@ -44,6 +44,7 @@ const QRegularExpression dependRepositoryRE =
 K9Atom::K9Atom(QString atom)
 {
     QRegularExpressionMatch regmatch;
+    op = NoOperator;
 
     regmatch = dependVersionRE.match(atom);
     if(regmatch.hasMatch())
@@ -53,6 +54,7 @@ K9Atom::K9Atom(QString atom)
         category = regmatch.captured(2);
         package = regmatch.captured(3);
         vs.parse(regmatch.captured(4));
+        op = decodeOperator(filter, vs.pvr);
         return;
     }
 
@@ -89,6 +91,7 @@ K9Atom::K9Atom(QString atom)
         category = regmatch.captured(2);
         package = regmatch.captured(3);
         vs.parse(regmatch.captured(4));
+        op = decodeOperator(filter, vs.pvr);
         slot = regmatch.captured(5);
         if(slot.contains('/'))
         {
@@ -178,164 +181,67 @@ bool K9Atom::globMatch(QString glob, QString s) const
     return match.hasMatch();
 }
 
-bool K9Atom::versionMatch(const VersionString& vb) const
+K9Atom::Operator K9Atom::decodeOperator(const QString& filter, const QString& version)
 {
-    if(filter == "=" && vs.pvr.contains("*") == false)
+    if(filter == "=")
     {
-        return vs.pvr == vb.pvr;
+        return version.contains('*') ? EqualGlob : Equal;
     }
-
-    int i;
-    qint64 a;
-    qint64 b;
-
-    if(filter == "=")
+    else if(filter == "<")
     {
-        if(vs.pvr.startsWith('*') && vs.pvr.endsWith('*'))
-        {
-            return vb.pvr.contains(vs.pvr.mid(1, vs.pvr.length() - 2));
-        }
-
-        for(i = 0; i < vs.vi.count() && i < vb.vi.count(); i++)
-        {
-            a = vs.vi.at(i);
-            b = vb.vi.at(i);
-            if(vs.vx.at(i).endsWith('*'))
-            {
-                if(a == b)
-                {
-                    return true;
-                }
-                return false;
-            }
-
-            if(a != b)
-            {
-                return false;
-            }
-        }
-
-        // both versions are equal
-        return true;
+        return Less;
     }
-
-    if(filter == "<=")
+    else if(filter == "<=")
     {
-        for(i = 0; i < vs.vi.count() && i < vb.vi.count(); i++)
-        {
-            a = vs.vi.at(i);
-            b = vb.vi.at(i);
-            if(a == b)
-            {
-                continue;
-            }
-
-            if(b > a)
-            {
-                return false;
-            }
-
-            if(b < a)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return true;
+        return LessEqual;
     }
-
-    if(filter == ">=")
+    else if(filter == "~")
     {
-        for(i = 0; i < vs.vi.count() && i < vb.vi.count(); i++)
-        {
-            a = vs.vi.at(i);
-            b = vb.vi.at(i);
-            if(a == b)
-            {
-                continue;
-            }
-
-            if(b < a)
-            {
-                return false;
-            }
-
-            if(b > a)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return true;
+        return Approximate;
     }
-
-
-    if(filter == "<")
+    else if(filter == ">=")
     {
-        for(i = 0; i < vs.vi.count() && i < vb.vi.count(); i++)
-        {
-            a = vs.vi.at(i);
-            b = vb.vi.at(i);
-            if(a == b)
-            {
-                continue;
-            }
-
-            if(b > a)
-            {
-                return false;
-            }
-
-            if(b < a)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return false;
+        return GreaterEqual;
+    }
+    else if(filter == ">")
+    {
+        return Greater;
     }
+    return NoOperator;
+}
 
-    if(filter == ">")
+bool K9Atom::versionMatch(const VersionString& vb) const
+{
+    switch(op)
     {
-        for(i = 0; i < vs.vi.count() && i < vb.vi.count(); i++)
-        {
-            a = vs.vi.at(i);
-            b = vb.vi.at(i);
-            if(a == b)
-            {
-                continue;
-            }
+        case Equal:
+            return vs.pvr == vb.pvr;
 
-            if(b < a)
+        case EqualGlob:
+            if(vs.pvr.startsWith('*') && vs.pvr.endsWith('*'))
             {
-                return false;
+                return vb.pvr.contains(vs.pvr.mid(1, vs.pvr.length() - 2));
             }
+            return VersionString::globMatch(vb.pvr, vs.pvr.left(vs.pvr.indexOf('*')));
 
-            if(b > a)
-            {
-                return true;
-            }
-        }
+        case Less:
+            return VersionString::compare(vb, vs) < 0;
 
-        // both versions are equal
-        return false;
-    }
+        case LessEqual:
+            return VersionString::compare(vb, vs) <= 0;
 
-    if(filter == "~")
-    {
-        for(i = 0; i < (MAXVX-1) && i < vs.vx.count() && i < vb.vx.count(); i++)
-        {
-            if(vs.vx.at(i) != vb.vx.at(i))
-            {
-                return false;
-            }
-        }
+        case Approximate:
+            // both versions are equal (while ignoring any -rX revision number differences)
+            return VersionString::compare(vb, vs, false) == 0;
 
-        // both versions are equal (while ignoring any -rX revision number differences)
-        return true;
+        case GreaterEqual:
+            return VersionString::compare(vb, vs) >= 0;
+
+        case Greater:
+            return VersionString::compare(vb, vs) > 0;
+
+        default:
+            break;
     }
 
     qDebug() << "Unknown filter op:" << filter << "App Version:" << vb.pvr << "Match Version" << vs.pvr;
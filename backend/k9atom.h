@@ -39,9 +39,17 @@ public:
         Unknown = 0, Version, Basic, Slot, Repository
     };
 
+    // filter, decoded once so matching doesn't compare strings
+    enum Operator
+    {
+        NoOperator = 0, Less, LessEqual, Equal, EqualGlob, Approximate, GreaterEqual, Greater
+    };
+    static Operator decodeOperator(const QString& filter, const QString& version);
+
     int atomId;
     AtomType type;
     QString filter;
+    Operator op;
     QString category;
     QString package;
     QString repo;
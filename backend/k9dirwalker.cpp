@@ -0,0 +1,106 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9dirwalker.h"
+
+#include <QFile>
+
+#include <algorithm>
+
+K9DirWalker::K9DirWalker()
+{
+    dirFd = -1;
+}
+
+K9DirWalker::~K9DirWalker()
+{
+    close();
+}
+
+bool K9DirWalker::open(const QString& path)
+{
+    return openAt(AT_FDCWD, QFile::encodeName(path).constData());
+}
+
+bool K9DirWalker::openAt(const K9DirWalker& parent, const QString& name)
+{
+    if(parent.isOpen() == false)
+    {
+        return false;
+    }
+    return openAt(parent.fd(), QFile::encodeName(name).constData());
+}
+
+bool K9DirWalker::openAt(int parentFd, const char* name)
+{
+    close();
+    dirFd = ::openat(parentFd, name, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return dirFd != -1;
+}
+
+void K9DirWalker::close()
+{
+    if(dirFd != -1)
+    {
+        ::close(dirFd);
+        dirFd = -1;
+    }
+}
+
+bool K9DirWalker::exists(const char* name) const
+{
+    return dirFd != -1 && faccessat(dirFd, name, F_OK, 0) == 0;
+}
+
+QStringList K9DirWalker::folders() const
+{
+    QStringList result;
+    visit([&result](const char* name, size_t length, bool isFolder)
+    {
+        if(isFolder)
+        {
+            result.append(QFile::decodeName(QByteArray(name, static_cast<int>(length))));
+        }
+    });
+
+    // QDir::entryList sorts by name, and the order categories are found in decides their CATEGORYID
+    std::sort(result.begin(), result.end());
+    return result;
+}
+
+QStringList K9DirWalker::files(const char* suffix) const
+{
+    QStringList result;
+    const size_t suffixLength = (suffix == nullptr) ? 0 : strlen(suffix);
+    visit([&result, suffix, suffixLength](const char* name, size_t length, bool isFolder)
+    {
+        if(isFolder)
+        {
+            return;
+        }
+
+        // compare the raw bytes, no need to decode names we're going to throw away
+        if(suffixLength && (length <= suffixLength || memcmp(name + length - suffixLength, suffix, suffixLength) != 0))
+        {
+            return;
+        }
+
+        result.append(QFile::decodeName(QByteArray(name, static_cast<int>(length))));
+    });
+
+    std::sort(result.begin(), result.end());
+    return result;
+}
@@ -0,0 +1,132 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9DIRWALKER_H
+#define K9DIRWALKER_H
+
+#include <QString>
+#include <QStringList>
+
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <dirent.h>
+
+// Lists a directory with getdents64 on a file descriptor that child folders
+// can be opened relative to, instead of QDir::entryList resolving and stat()ing
+// full paths at every level of the repo tree. Entry types come from d_type, so
+// only filesystems that don't fill it in cost an extra fstatat per entry.
+// Hidden entries are skipped, the same as QDir does by default.
+class K9DirWalker
+{
+public:
+    K9DirWalker();
+    ~K9DirWalker();
+
+    bool open(const QString& path);
+    bool openAt(const K9DirWalker& parent, const QString& name);
+    bool openAt(int parentFd, const char* name);
+    void close(void);
+    bool isOpen(void) const { return dirFd != -1; }
+    int fd(void) const { return dirFd; }
+
+    bool exists(const char* name) const;
+
+    QStringList folders(void) const;
+    QStringList files(const char* suffix = nullptr) const;
+
+    // Calls visitor(const char* name, size_t length, bool isFolder) for every entry.
+    template<typename Visitor> bool visit(Visitor visitor) const;
+
+private:
+    int dirFd;
+
+    struct LinuxDirent64
+    {
+        uint64_t d_ino;
+        int64_t d_off;
+        unsigned short d_reclen;
+        unsigned char d_type;
+        char d_name[];
+    };
+
+    K9DirWalker(const K9DirWalker&) = delete;
+    K9DirWalker& operator=(const K9DirWalker&) = delete;
+};
+
+template<typename Visitor> bool K9DirWalker::visit(Visitor visitor) const
+{
+    if(dirFd == -1)
+    {
+        return false;
+    }
+
+    // getdents64 continues from the descriptor's offset, so start over in case we've been here before
+    lseek(dirFd, 0, SEEK_SET);
+
+    alignas(LinuxDirent64) char buffer[32768];
+    const LinuxDirent64* entry;
+    struct stat sb;
+    bool isFolder;
+    long length;
+    long offset;
+    while((length = syscall(SYS_getdents64, dirFd, buffer, sizeof(buffer))) > 0)
+    {
+        for(offset = 0; offset < length; offset += entry->d_reclen)
+        {
+            entry = reinterpret_cast<const LinuxDirent64*>(buffer + offset);
+            if(entry->d_name[0] == '.')
+            {
+                continue;
+            }
+
+            if(entry->d_type == DT_DIR)
+            {
+                isFolder = true;
+            }
+            else if(entry->d_type == DT_REG)
+            {
+                isFolder = false;
+            }
+            else if(entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK)
+            {
+                // follow symlinks like QDir does
+                if(fstatat(dirFd, entry->d_name, &sb, 0) != 0)
+                {
+                    continue;
+                }
+                isFolder = S_ISDIR(sb.st_mode);
+                if(isFolder == false && S_ISREG(sb.st_mode) == false)
+                {
+                    continue;
+                }
+            }
+            else
+            {
+                continue;
+            }
+
+            visitor(entry->d_name, strlen(entry->d_name), isFolder);
+        }
+    }
+
+    return length == 0;
+}
+
+#endif // K9DIRWALKER_H
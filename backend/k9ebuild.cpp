@@ -0,0 +1,69 @@
+// Copyright (c) 2021-2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9ebuild.h"
+#include "globals.h"
+
+#include <QFile>
+#include <QMutexLocker>
+
+K9Ebuild::K9Ebuild()
+{
+}
+
+// Starts over with another package version. Its metadata is empty until ebuildReader() or
+// EBUILDCACHE fills it in.
+void K9Ebuild::setPackage(const QString& name, const QString& v)
+{
+    packageName = name;
+    version.parse(v);
+    metadata.clear();
+}
+
+// see https://devmanual.gentoo.org/ebuild-writing/variables/ for a list of all predefined read-only variables in an ebuild
+// portageq envvar might be useful to retrieve more variables
+// portageq envvar CFLAGS
+static const char* const predefinedNames[] = { "PN", "PV", "PR", "PVR", "P", "PF" };
+static const int predefinedCount = 6;
+
+// Reads the ebuild's metadata assignments. They can expand the predefined variables, which are
+// only worked out here so that packages read from md5-cache don't pay for them.
+void K9Ebuild::ebuildReader(QString fileName)
+{
+    QFile input(fileName);
+    if(!input.exists())
+    {
+        QMutexLocker lock(&outputMutex);
+        output << "eBuild " << input.fileName() << " does not exist." << Qt::endl;
+        return;
+    }
+
+    if(!input.open(QIODevice::ReadOnly))
+    {
+        QMutexLocker lock(&outputMutex);
+        output << "eBuild " << input.fileName() << " could not be opened for reading." << Qt::endl;
+        return;
+    }
+
+    const QByteArray script = input.readAll();
+    input.close();
+
+    const QByteArray pn = packageName.toUtf8();
+    const QByteArray pv = version.pv().toUtf8();
+    const QByteArray pvr = version.pvr.toUtf8();
+    const QByteArray predefinedValues[predefinedCount] = { pn, pv, version.pr().toUtf8(), pvr, pn + '-' + pv, pn + '-' + pvr };
+    lexer.parse(script, predefinedNames, predefinedValues, predefinedCount, metadata);
+}
@@ -0,0 +1,44 @@
+// Copyright (c) 2021-2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9EBUILD_H
+#define K9EBUILD_H
+
+#include "versionstring.h"
+#include "k9metadata.h"
+#include "k9metacache.h"
+#include "k9shelllexer.h"
+
+#include <QString>
+
+// Per-package parser state. Each import worker owns its own K9Ebuild so that
+// ebuild and md5-cache variables never get shared between threads.
+class K9Ebuild
+{
+public:
+    K9Ebuild();
+
+    void setPackage(const QString& packageName, const QString& version);
+    QString packageName; // PN
+    VersionString version;
+    K9Metadata metadata; // values read by ebuildReader() or taken from EBUILDCACHE
+
+    void ebuildReader(QString fileName);
+    K9MetaCache metaCache; // the last md5-cache entry read for this worker
+    K9ShellLexer lexer;
+};
+
+#endif // K9EBUILD_H
@@ -0,0 +1,157 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9eclassindex.h"
+#include "globals.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QStringList>
+#include <QVariant>
+
+K9EclassIndex::K9EclassIndex()
+{
+    insertEclass = nullptr;
+    deleteRows = nullptr;
+    insertRow = nullptr;
+}
+
+K9EclassIndex::~K9EclassIndex()
+{
+    clear();
+}
+
+// Reads the eclass names we already have ids for and prepares the writes.
+bool K9EclassIndex::load(QSqlDatabase& db)
+{
+    clear();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    if(query.exec("select ECLASSID, ECLASS from ECLASS") == false)
+    {
+        output << "Couldn't read ECLASS: " << query.lastError().text() << Qt::endl;
+        return false;
+    }
+
+    while(query.next())
+    {
+        ids.insert(query.value(1).toString(), query.value(0).toLongLong());
+    }
+
+    insertEclass = new QSqlQuery(db);
+    insertEclass->prepare("insert into ECLASS (ECLASS) values(?)");
+    deleteRows = new QSqlQuery(db);
+    deleteRows->prepare("delete from PACKAGEECLASS where PACKAGEID=?");
+    insertRow = new QSqlQuery(db);
+    insertRow->prepare("insert into PACKAGEECLASS (PACKAGEID, ECLASSID, DIRECT) values(?, ?, ?)");
+    return true;
+}
+
+void K9EclassIndex::clear()
+{
+    ids.clear();
+    delete insertEclass;
+    delete deleteRows;
+    delete insertRow;
+    insertEclass = nullptr;
+    deleteRows = nullptr;
+    insertRow = nullptr;
+}
+
+// Replaces the package's rows with one per eclass in eclasses (space separated), marking
+// the ones also named in inherit as inherited directly. Without an inherit list (the VDB
+// doesn't keep one) DIRECT is left NULL.
+bool K9EclassIndex::write(qint64 packageId, const QString& eclasses, const QString& inherit)
+{
+    if(deleteRows == nullptr)
+    {
+        return false;
+    }
+
+    deleteRows->bindValue(0, packageId);
+    if(deleteRows->exec() == false)
+    {
+        output << "Query failed:" << deleteRows->executedQuery() << deleteRows->lastError().text() << Qt::endl;
+        return false;
+    }
+
+    if(eclasses.isEmpty())
+    {
+        return true;
+    }
+
+    const QStringList direct = inherit.split(' ', Qt::SkipEmptyParts);
+    qint64 eclassId;
+    foreach(const QString& eclass, eclasses.split(' ', Qt::SkipEmptyParts))
+    {
+        QHash<QString, qint64>::const_iterator it = ids.constFind(eclass);
+        if(it != ids.constEnd())
+        {
+            eclassId = it.value();
+        }
+        else
+        {
+            insertEclass->bindValue(0, eclass);
+            if(insertEclass->exec() == false)
+            {
+                output << "Query failed:" << insertEclass->executedQuery() << insertEclass->lastError().text() << Qt::endl;
+                return false;
+            }
+            eclassId = insertEclass->lastInsertId().toLongLong();
+            ids.insert(eclass, eclassId);
+        }
+
+        insertRow->bindValue(0, packageId);
+        insertRow->bindValue(1, eclassId);
+        if(direct.isEmpty())
+        {
+#if QT_VERSION < 0x060000
+            insertRow->bindValue(2, QVariant(QVariant::Int)); // NULL, not known
+#else
+            insertRow->bindValue(2, QVariant(QMetaType::fromType<int>())); // NULL, not known
+#endif
+        }
+        else
+        {
+            insertRow->bindValue(2, direct.contains(eclass) ? 1 : 0);
+        }
+        if(insertRow->exec() == false)
+        {
+            output << "Query failed:" << insertRow->executedQuery() << insertRow->lastError().text() << Qt::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// Deletes the rows of PACKAGE rows that are gone and the eclasses nothing inherits anymore.
+// Forgets the cached ids, so call load() again before writing more rows.
+bool K9EclassIndex::prune(QSqlQuery& query)
+{
+    clear();
+
+    if(query.exec("delete from PACKAGEECLASS where PACKAGEID not in (select PACKAGEID from PACKAGE)") == false ||
+       query.exec("delete from ECLASS where ECLASSID not in (select ECLASSID from PACKAGEECLASS)") == false)
+    {
+        output << "Couldn't prune ECLASS: " << query.lastError().text() << Qt::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9ECLASSINDEX_H
+#define K9ECLASSINDEX_H
+
+#include <QString>
+#include <QHash>
+
+class QSqlDatabase;
+class QSqlQuery;
+
+// Keeps ECLASS and PACKAGEECLASS in step with the PACKAGE rows the database writer
+// stores, so "what inherits this eclass" is an index lookup instead of a grep through
+// every repo. Only the database writer thread may use it.
+class K9EclassIndex
+{
+public:
+    K9EclassIndex();
+    ~K9EclassIndex();
+
+    bool load(QSqlDatabase& db);
+    void clear(void);
+    bool write(qint64 packageId, const QString& eclasses, const QString& inherit);
+    bool prune(QSqlQuery& query);
+
+private:
+    QHash<QString, qint64> ids;
+    QSqlQuery* insertEclass;
+    QSqlQuery* deleteRows;
+    QSqlQuery* insertRow;
+
+    K9EclassIndex(const K9EclassIndex&) = delete;
+    K9EclassIndex& operator=(const K9EclassIndex&) = delete;
+};
+
+#endif // K9ECLASSINDEX_H
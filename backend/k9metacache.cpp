@@ -0,0 +1,133 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+#include "k9metacache.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+K9MetaCache::K9MetaCache()
+{
+    buffer.resize(8192);
+    clear();
+}
+
+void K9MetaCache::clear()
+{
+    length = 0;
+    for(int i = 0; i < K9Metadata::keyCount; i++)
+    {
+        offsets[i] = 0;
+        lengths[i] = -1;
+    }
+}
+
+// Returns false when the file can't be read, leaving every key empty.
+bool K9MetaCache::read(const QString& fileName)
+{
+    clear();
+    int fd = ::open(QFile::encodeName(fileName).constData(), O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        return false;
+    }
+
+    ssize_t count;
+    for(;;)
+    {
+        if(length == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+
+        count = ::read(fd, buffer.data() + length, buffer.size() - length);
+        if(count > 0)
+        {
+            length += count;
+        }
+        else if(count == 0 || errno != EINTR)
+        {
+            break;
+        }
+    }
+    ::close(fd);
+
+    if(count < 0)
+    {
+        length = 0;
+        return false;
+    }
+
+    scan();
+    return true;
+}
+
+void K9MetaCache::scan()
+{
+    const char* start = buffer.constData();
+    const char* end = start + length;
+    const char* line = start;
+    const char* lineEnd;
+    const char* equals;
+    const char* valueStart;
+    const char* valueEnd;
+    int key;
+    while(line < end)
+    {
+        lineEnd = static_cast<const char*>(memchr(line, '\n', end - line));
+        if(lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+
+        equals = static_cast<const char*>(memchr(line, '=', lineEnd - line));
+        if(equals != nullptr)
+        {
+            key = K9Metadata::find(line, static_cast<int>(equals - line));
+            if(key != -1)
+            {
+                valueStart = equals + 1;
+                valueEnd = lineEnd;
+                while(valueStart < valueEnd && (*valueStart == ' ' || *valueStart == '\t'))
+                {
+                    valueStart++;
+                }
+                while(valueEnd > valueStart && (valueEnd[-1] == ' ' || valueEnd[-1] == '\t' || valueEnd[-1] == '\r'))
+                {
+                    valueEnd--;
+                }
+                offsets[key] = static_cast<int>(valueStart - start);
+                lengths[key] = static_cast<int>(valueEnd - valueStart);
+            }
+        }
+
+        line = lineEnd + 1;
+    }
+}
+
+QString K9MetaCache::value(Key key) const
+{
+    if(lengths[key] == -1)
+    {
+        return QString();
+    }
+    return QString::fromUtf8(buffer.constData() + offsets[key], lengths[key]);
+}
@@ -0,0 +1,54 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+
+#ifndef K9METACACHE_H
+#define K9METACACHE_H
+
+#include "k9metadata.h"
+
+#include <QByteArray>
+#include <QString>
+
+// Reads a repo's metadata/md5-cache entry into a reusable buffer and remembers where the
+// values of the K9Metadata keys start and end, without building a QString for every line or a
+// hash of every key. Lines and the '=' in them are found with memchr(), which glibc
+// vectorizes. Values are only decoded when somebody asks for them.
+class K9MetaCache
+{
+public:
+    typedef K9Metadata::Key Key;
+
+    K9MetaCache();
+
+    bool read(const QString& fileName);
+    void clear(void);
+
+    bool contains(Key key) const { return lengths[key] != -1; }
+    const char* data(Key key) const { return buffer.constData() + offsets[key]; }
+    int size(Key key) const { return qMax(lengths[key], 0); }
+    QString value(Key key) const;
+
+private:
+    QByteArray buffer;
+    int length;
+    int offsets[K9Metadata::keyCount];
+    int lengths[K9Metadata::keyCount]; // -1 when the key wasn't in the file
+
+    void scan(void);
+};
+
+#endif // K9METACACHE_H
@@ -0,0 +1,93 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9metadata.h"
+
+#include <cstring>
+
+struct MetadataKeyName
+{
+    const char* name;
+    int length;
+    int key;
+};
+
+// Indexed by K9Metadata::hash(); the static_asserts below fail the build if a key is
+// added that lands on somebody else's slot.
+static const MetadataKeyName hashTable[K9Metadata::hashSize] =
+{
+    { nullptr, 0, -1 },
+    { "KEYWORDS", 8, K9Metadata::keywords },
+    { "HOMEPAGE", 8, K9Metadata::homepage },
+    { "IUSE", 4, K9Metadata::iuse },
+    { nullptr, 0, -1 },
+    { "_md5_", 5, K9Metadata::md5 },
+    { nullptr, 0, -1 },
+    { nullptr, 0, -1 },
+    { "DESCRIPTION", 11, K9Metadata::description },
+    { "INHERIT", 7, K9Metadata::inherit },
+    { nullptr, 0, -1 },
+    { "SLOT", 4, K9Metadata::slot },
+    { nullptr, 0, -1 },
+    { "_eclasses_", 10, K9Metadata::eclasses },
+    { "LICENSE", 7, K9Metadata::license },
+    { nullptr, 0, -1 }
+};
+
+static_assert(K9Metadata::hash("KEYWORDS", 8) == 1, "KEYWORDS moved in the metadata hash table");
+static_assert(K9Metadata::hash("HOMEPAGE", 8) == 2, "HOMEPAGE moved in the metadata hash table");
+static_assert(K9Metadata::hash("IUSE", 4) == 3, "IUSE moved in the metadata hash table");
+static_assert(K9Metadata::hash("_md5_", 5) == 5, "_md5_ moved in the metadata hash table");
+static_assert(K9Metadata::hash("DESCRIPTION", 11) == 8, "DESCRIPTION moved in the metadata hash table");
+static_assert(K9Metadata::hash("INHERIT", 7) == 9, "INHERIT moved in the metadata hash table");
+static_assert(K9Metadata::hash("SLOT", 4) == 11, "SLOT moved in the metadata hash table");
+static_assert(K9Metadata::hash("_eclasses_", 10) == 13, "_eclasses_ moved in the metadata hash table");
+static_assert(K9Metadata::hash("LICENSE", 7) == 14, "LICENSE moved in the metadata hash table");
+
+static const char* const keyNames[K9Metadata::keyCount] = { "DESCRIPTION", "HOMEPAGE", "SLOT", "KEYWORDS", "IUSE", "LICENSE", "_md5_", "_eclasses_", "INHERIT" };
+
+K9Metadata::K9Metadata()
+{
+    present = 0;
+}
+
+int K9Metadata::find(const char* name, int length)
+{
+    if(length <= 0)
+    {
+        return -1;
+    }
+
+    const MetadataKeyName& entry = hashTable[hash(name, length)];
+    if(entry.length != length || memcmp(entry.name, name, length) != 0)
+    {
+        return -1;
+    }
+    return entry.key;
+}
+
+const char* K9Metadata::name(Key key)
+{
+    return keyNames[key];
+}
+
+// Assigning shares the QString's data, so nothing is copied and the slot's previous value
+// is released at the same time.
+void K9Metadata::setValue(Key key, const QString& value)
+{
+    values[key] = value;
+    present |= 1u << key;
+}
@@ -0,0 +1,66 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9METADATA_H
+#define K9METADATA_H
+
+#include <QString>
+
+// The metadata an import worker keeps for one package version, in fixed slots that are
+// reused from one package to the next instead of a QHash<QString, QString> that gets
+// cleared and refilled (and every key hashed) for each of them. Key names are looked
+// up with a perfect hash that's checked at compile time, so the md5-cache and ebuild
+// variables nobody reads (DEFINED_PHASES, RDEPEND, MY_PV...) cost one table probe.
+class K9Metadata
+{
+public:
+    enum Key
+    {
+        description = 0,
+        homepage,
+        slot,
+        keywords,
+        iuse,
+        license,
+        md5, // _md5_ of the ebuild
+        eclasses, // _eclasses_ names and md5s
+        inherit, // INHERIT, the eclasses the ebuild names itself
+        keyCount
+    };
+    static const int ebuildKeyCount = md5; // keys an ebuild assigns itself, the rest only exist in md5-cache
+
+    K9Metadata();
+
+    static int find(const char* name, int length); // the Key, or -1 for names we don't keep
+    static const char* name(Key key);
+
+    void clear(void) { present = 0; }
+    bool contains(Key key) const { return (present & (1u << key)) != 0; }
+    QString value(Key key) const { return contains(key) ? values[key] : QString(); }
+    void setValue(Key key, const QString& value);
+
+    static constexpr int hash(const char* name, int length)
+    {
+        return (static_cast<unsigned char>(name[0]) + (static_cast<unsigned char>(name[length - 1]) << 1) + (length << 3)) & (hashSize - 1);
+    }
+    static const int hashSize = 16;
+
+private:
+    QString values[keyCount];
+    unsigned int present; // bit per Key that was set since clear()
+};
+
+#endif // K9METADATA_H
@@ -15,29 +15,17 @@
 // Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 
 #include "k9portage.h"
-#include "datastorage.h"
 #include "globals.h"
 
 #include <QDir>
 #include <QDebug>
-#include <QFile>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QDateTime>
 #include <QRegularExpressionMatch>
 
 K9Portage::K9Portage(QObject *parent) : QObject(parent)
 {
-    separator.setPattern("([^A-Za-z0-9]+)");
-    digitVersion.setPattern("([0-9]+)");
-    alphaVersion.setPattern("([A-Za-z]+)");
-
-    stringAssignment.setPattern("([^=]+)\\s*=\\s*\"((\\\\\"|[^\"])*)\"");
-    variableAssignment.setPattern("([^=]+)\\s*=\\s*([^\"]*)");
-    verCutSingle.setPattern("\\$\\((ver_cut|get_version_component_range)\\s+([0-9]+)\\)");
-    verCutRange.setPattern("\\$\\((ver_cut|get_version_component_range)\\s+([0-9]+)-([0-9]+)\\)");
-    var_ref.setPattern("\\$\\{([A-z, 0-9, _]+)\\}");
+    vdbFolder = "/var/db/pkg/";
+    configFolder = "/etc/portage/";
+    emergeLog = "/var/log/emerge.log";
 
     // see https://devmanual.gentoo.org/general-concepts/dependencies/
     // See Restrictions upon Names: https://projects.gentoo.org/pms/8/pms.html#x1-150003
@@ -112,6 +100,20 @@ The following operators are available:
 
 }
 
+// Looks for the repos, installed packages and portage config under path instead of /, like emerge --root.
+void K9Portage::setRoot(QString path)
+{
+    while(path.endsWith('/'))
+    {
+        path.chop(1);
+    }
+
+    vdbFolder = path + "/var/db/pkg/";
+    configFolder = path + "/etc/portage/";
+    emergeLog = path + "/var/log/emerge.log";
+    setRepoFolder(path + "/var/db/repos/");
+}
+
 void K9Portage::setRepoFolder(QString path)
 {
     repoFolder = path;
@@ -129,329 +131,11 @@ void K9Portage::setRepoFolder(QString path)
     dir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
     repos.clear();
 
-    int i, j;
+    // categories are left for ImportVDB to list, only the runs that import whole repos need them
     QStringList repoFolders = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
     const int repoFolderCount = repoFolders.count();
-    for(i = 0; i < repoFolderCount; i++)
+    for(int i = 0; i < repoFolderCount; i++)
     {
         repos.append(QString("%1%2/").arg(repoFolder, repoFolders.at(i)));
     }
-
-    categories.clear();
-
-    QString s;
-    QStringList repoCategories;
-    for(i = 0; i < repoFolderCount; i++)
-    {
-        dir.setPath(repos.at(i));
-        dir.setFilter(QDir::Dirs | QDir::NoDotAndDotDot);
-        repoCategories = dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot);
-        const int repoCategoriesCount = repoCategories.count();
-        for(j = 0; j < repoCategoriesCount; j++)
-        {
-            s = repoCategories.at(j);
-            if(categories.contains(s) == false)
-            {
-                categories.append(s);
-            }
-        }
-    }
-}
-
-// see https://devmanual.gentoo.org/ebuild-writing/variables/ for a list of all predefined read-only variables in an ebuild
-// portageq envvar might be useful to retrieve more variables
-// portageq envvar CFLAGS
-void K9Portage::setVersion(QString v)
-{
-    version.parse(v);
-    vars["PVR"] = version.pvr;
-    vars["PV"] = version.pv();
-    vars["PR"] = version.pr();
-    vars["P"] = QString("%1-%2").arg(vars["PN"], vars["PV"]);
-    vars["PF"] = QString("%1-%2").arg(vars["PN"], version.pvr);
-}
-
-QVariant K9Portage::var(QString key)
-{
-    if(vars.contains(key))
-    {
-        return vars[key];
-    }
-
-#if QT_VERSION < 0x060000
-    return QVariant(QVariant::String);
-#else
-    return QVariant(QMetaType::fromType<QString>());
-#endif
-}
-
-void K9Portage::parseVerCut(QString& value)
-{
-    bool matchFound;
-    QRegularExpressionMatch match;
-    int i, j;
-    do
-    {
-        matchFound = false;
-        match = verCutRange.match(value);
-        if(match.hasMatch())
-        {
-            matchFound = true;
-            i = match.captured(2).toInt() - 1;
-            j = match.captured(3).toInt() - 1;
-            value.replace(match.capturedStart(), match.capturedLength(), QString("%1.%2").arg(version.cut(i), version.cut(j)));
-        }
-
-        match = verCutSingle.match(value);
-        if(match.hasMatch())
-        {
-            matchFound = true;
-            i = match.captured(2).toInt() - 1;
-            value.replace(match.capturedStart(), match.capturedLength(), version.cut(i));
-        }
-    } while(matchFound);
-}
-
-void K9Portage::emergedApp(QStringList appList)
-{
-    QSqlDatabase db;
-    if(QSqlDatabase::contains("GuiThread") == false)
-    {
-        db = QSqlDatabase::addDatabase("QSQLITE", "GuiThread");
-    }
-    else
-    {
-        db = QSqlDatabase::database("GuiThread");
-        if(db.isValid())
-        {
-            db.close();
-        }
-    }
-
-    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
-    db.open();
-
-    QSqlQuery query(db);
-    QSqlQuery updatePackage(db);
-    QSqlQuery deletePackage(db);
-    query.prepare(QStringLiteral(R"EOF(
-select PACKAGEID, VERSION, INSTALLED, OBSOLETED, DOWNLOADSIZE
-from PACKAGE
-where CATEGORYID=(select CATEGORYID from CATEGORY where CATEGORY=?) and PACKAGE=?
-)EOF"));
-    updatePackage.prepare(QStringLiteral("update PACKAGE set INSTALLED=?, DOWNLOADSIZE=? where PACKAGEID=?"));
-    deletePackage.prepare(QStringLiteral("delete from PACKAGE where PACKAGEID=?"));
-
-    QStringList x;
-    QString category;
-    QString packageName;
-    QFile input;
-    QString data;
-    bool ok;
-
-    qint64 packageId;
-    qint64 installed;
-    QString version;
-    QString installedFilePath;
-    int downloadSize;
-    QFileInfo fi;
-    bool obsoleted;
-
-    const int appCount = appList.count();
-    for(int i = 0; i < appCount; i++)
-    {
-        x = appList.at(i).split('/');
-        category = x.first();
-        packageName = x.last();
-        query.bindValue(0, category);
-        query.bindValue(1, packageName);
-
-        if(query.exec() == false || query.first() == false)
-        {
-            return;
-        }
-
-        do
-        {
-            packageId = query.value(0).toInt();
-            version = query.value(1).toString();
-            installed = query.value(2).toInt();
-            obsoleted = query.value(3).toInt() != 0;
-            downloadSize = query.value(4).toInt();
-
-            if(downloadSize == -1)
-            {
-                data = QString("/var/db/pkg/%1/%2-%3/SIZE").arg(category, packageName, version);
-                input.setFileName(data);
-                if(input.open(QIODevice::ReadOnly))
-                {
-                    data = input.readAll();
-                    input.close();
-                    data = data.trimmed();
-                    downloadSize = data.toInt(&ok);
-                    if(ok == false)
-                    {
-                        downloadSize = -1;
-                    }
-                }
-            }
-
-            installedFilePath = QString("/var/db/pkg/%1/%2-%3").arg(category, packageName, version);
-            fi.setFile(installedFilePath);
-            if(fi.exists())
-            {
-                if(installed == 0)
-                {
-                    installed = fi.birthTime().toSecsSinceEpoch();
-                    updatePackage.bindValue(0, installed);
-                    updatePackage.bindValue(1, downloadSize);
-                    updatePackage.bindValue(2, packageId);
-                    if(updatePackage.exec() == false)
-                    {
-                        output << QString("update installed %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
-                    }
-                }
-            }
-            else
-            {
-                if(installed)
-                {
-                    if(obsoleted)
-                    {
-                        deletePackage.bindValue(0, packageId);
-                        if(deletePackage.exec() == false)
-                        {
-                            output << QString("delete uninstalled obsolete %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
-                        }
-                    }
-                    else
-                    {
-                        installed = 0;
-                        updatePackage.bindValue(0, installed);
-                        updatePackage.bindValue(1, downloadSize);
-                        updatePackage.bindValue(2, packageId);
-                        if(updatePackage.exec() == false)
-                        {
-                            output << QString("update uninstalled %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
-                        }
-                    }
-                }
-            }
-        } while(query.next());
-    }
-}
-
-void K9Portage::ebuildReader(QString fileName)
-{
-    QFile input(fileName);
-    if(!input.exists())
-    {
-        output << "eBuild " << input.fileName() << " does not exist." << Qt::endl;
-        return;
-    }
-
-    if(!input.open(QIODevice::ReadOnly))
-    {
-        output << "eBuild " << input.fileName() << " could not be opened for reading." << Qt::endl;
-        return;
-    }
-
-    QString s = input.readAll();
-    input.close();
-
-    QString key;
-    QString value;
-    QRegularExpressionMatch match;
-
-    QStringList lines = s.split('\n');
-    const int lineCount = lines.count();
-    for(int line = 0; line < lineCount; line++)
-    {
-        s = lines.at(line).trimmed();
-        if(s.isEmpty() || s.startsWith('#'))
-        {
-            continue;
-        }
-
-        match = stringAssignment.match(s, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
-        if(match.hasMatch() && match.lastCapturedIndex() >= 2)
-        {
-            key = match.captured(1).toUpper();
-            value = match.captured(2).replace("\\\"", "\"");
-        }
-        else
-        {
-            match = variableAssignment.match(s, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
-            if(match.hasMatch() && match.lastCapturedIndex() >= 2)
-            {
-                key = match.captured(1).toUpper();
-                value = match.captured(2);
-            }
-        }
-
-        if(key.isEmpty() == false)
-        {
-            parseVerCut(value);
-
-            match = var_ref.match(value, 0, QRegularExpression::PartialPreferFirstMatch, QRegularExpression::NoMatchOption);
-            while(match.hasMatch())
-            {
-                s = match.captured(1).toUpper();
-                if(vars.contains(s))
-                {
-                    value.replace(match.capturedStart(), match.capturedLength(), vars[s]);
-                }
-                else
-                {
-                    value.remove(match.capturedStart(), match.capturedLength());
-                }
-                match = var_ref.match(value, 0, QRegularExpression::NormalMatch, QRegularExpression::NoMatchOption);
-            }
-
-            vars[key] = value;
-            key.clear();
-        }
-    }
-}
-
-void K9Portage::md5cacheReader(QString fileName)
-{
-    QFile input(fileName);
-    if(!input.exists())
-    {
-        output << "md5-cache " << input.fileName() << " does not exist." << Qt::endl;
-        return;
-    }
-
-    if(!input.open(QIODevice::ReadOnly))
-    {
-        output << "md5-cache " << input.fileName() << " could not be opened for reading." << Qt::endl;
-        return;
-    }
-
-    QString s = input.readAll();
-    input.close();
-
-    int i;
-    QString key;
-    QString value;
-    QStringList lines = s.split('\n');
-    const int lineCount = lines.count();
-    for(int line = 0; line < lineCount; line++)
-    {
-        s = lines.at(line).trimmed();
-        if(s.isEmpty() || s.startsWith('#'))
-        {
-            continue;
-        }
-
-        i = s.indexOf('=');
-        if(i == -1)
-        {
-            continue;
-        }
-        key = s.left(i);
-        value = s.mid(i + 1);
-        vars[key] = value;
-    }
 }
@@ -35,39 +35,19 @@ public:
 
     QString arch;
 
+    void setRoot(QString path);
     void setRepoFolder(QString path);
     QString repoFolder;
     QStringList repos;
-
-    QStringList categories;
-
-    void setVersion(QString version);
-    VersionString version;
-    QHash<QString, QString> vars;
-    QVariant var(QString key);
-
-    void ebuildReader(QString fileName);
-    void md5cacheReader(QString fileName);
-
-    void parseVerCut(QString& value);
-    QRegularExpression verCutSingle;
-    QRegularExpression verCutRange;
-
-    QRegularExpression separator;
-    QRegularExpression digitVersion;
-    QRegularExpression alphaVersion;
-
-    QRegularExpression stringAssignment;
-    QRegularExpression variableAssignment;
-    QRegularExpression var_ref;
+    QString vdbFolder; // installed packages, /var/db/pkg/ unless setRoot() moved it
+    QString configFolder; // /etc/portage/ unless setRoot() moved it
+    QString emergeLog; // /var/log/emerge.log unless setRoot() moved it
 
     QRegularExpression dependKeywordsBasicRE;
     QRegularExpression dependKeywordsVersionRE;
     QRegularExpression dependKeywordsSlotRE;
     QRegularExpression dependKeywordsRepositoryRE;
 
-    void emergedApp(QStringList appList);
-
     enum PackageStatus
     {
         UNKNOWN = 0,
@@ -0,0 +1,1422 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9shelllexer.h"
+
+#include <climits>
+#include <cstring>
+
+// Words that open or close a compound command. Whatever follows one starts a new command.
+static const char* const reservedWords[] = { "if", "then", "else", "elif", "fi", "do", "done", "while", "until", "for", "case", "esac", "select", "time", nullptr };
+
+// Builtins whose arguments are assignments.
+static const char* const declarationWords[] = { "export", "declare", "readonly", "local", "typeset", nullptr };
+
+static bool isOneOf(const QByteArray& word, const char* const* list)
+{
+    for(; *list != nullptr; list++)
+    {
+        if(word == *list)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static bool isAlpha(char c)
+{
+    return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+}
+
+// Matches one character of a glob pattern at pattern[i], setting next to the index after it.
+static bool globMatchOne(const char* pattern, int patternLength, int i, char c, int& next)
+{
+    const char pc = pattern[i];
+    if(pc == '?')
+    {
+        next = i + 1;
+        return true;
+    }
+
+    if(pc == '\\' && i + 1 < patternLength)
+    {
+        next = i + 2;
+        return pattern[i + 1] == c;
+    }
+
+    if(pc == '[')
+    {
+        int j = i + 1;
+        bool negate = false;
+        if(j < patternLength && (pattern[j] == '!' || pattern[j] == '^'))
+        {
+            negate = true;
+            j++;
+        }
+
+        // a ']' right at the start of the class is just a character
+        int close = j + 1;
+        while(close < patternLength && pattern[close] != ']')
+        {
+            close++;
+        }
+
+        if(close < patternLength)
+        {
+            bool found = false;
+            for(int k = j; k < close; k++)
+            {
+                if(k + 2 < close && pattern[k + 1] == '-')
+                {
+                    if(c >= pattern[k] && c <= pattern[k + 2])
+                    {
+                        found = true;
+                    }
+                    k += 2;
+                }
+                else if(pattern[k] == c)
+                {
+                    found = true;
+                }
+            }
+            next = close + 1;
+            return found != negate;
+        }
+    }
+
+    next = i + 1;
+    return pc == c;
+}
+
+// Bash's pattern matching for ${VAR%pattern} and friends: *, ?, [...] and backslash escapes.
+static bool globMatch(const QByteArray& pattern, const char* s, int length)
+{
+    const char* pat = pattern.constData();
+    const int patternLength = pattern.size();
+    int pi = 0;
+    int si = 0;
+    int starP = -1;
+    int starS = 0;
+    int next;
+    while(si < length)
+    {
+        if(pi < patternLength)
+        {
+            if(pat[pi] == '*')
+            {
+                starP = ++pi;
+                starS = si;
+                continue;
+            }
+
+            if(globMatchOne(pat, patternLength, pi, s[si], next))
+            {
+                pi = next;
+                si++;
+                continue;
+            }
+        }
+
+        if(starP == -1)
+        {
+            return false;
+        }
+
+        // let the last * swallow one more character and try again
+        pi = starP;
+        si = ++starS;
+    }
+
+    while(pi < patternLength && pat[pi] == '*')
+    {
+        pi++;
+    }
+    return pi == patternLength;
+}
+
+// ${VAR%pattern}, ${VAR%%pattern}, ${VAR#pattern} and ${VAR##pattern}
+static QByteArray removePattern(const QByteArray& value, const QByteArray& pattern, bool suffix, bool longest)
+{
+    const int n = value.size();
+    int i;
+    for(int k = 0; k <= n; k++)
+    {
+        if(suffix)
+        {
+            i = longest ? k : n - k;
+            if(globMatch(pattern, value.constData() + i, n - i))
+            {
+                return value.left(i);
+            }
+        }
+        else
+        {
+            i = longest ? n - k : k;
+            if(globMatch(pattern, value.constData(), i))
+            {
+                return value.mid(i);
+            }
+        }
+    }
+    return value;
+}
+
+// ${VAR/pattern/replacement}; mode is '/' for the first match, 'a' for all of them,
+// '#' for a match at the start and '%' for one at the end.
+static QByteArray replacePattern(const QByteArray& value, const QByteArray& pattern, const QByteArray& replacement, char mode)
+{
+    if(pattern.isEmpty())
+    {
+        return value;
+    }
+
+    const int n = value.size();
+    QByteArray result;
+    int i = 0;
+    int j;
+    int k;
+    while(i < n)
+    {
+        if(mode == '#' && i > 0)
+        {
+            break;
+        }
+
+        // longest match starting at i
+        j = -1;
+        for(k = n; k > i; k--)
+        {
+            if(globMatch(pattern, value.constData() + i, k - i))
+            {
+                j = k;
+                break;
+            }
+
+            if(mode == '%')
+            {
+                break;
+            }
+        }
+
+        if(j != -1)
+        {
+            result.append(replacement);
+            i = j;
+            if(mode != 'a')
+            {
+                break;
+            }
+            continue;
+        }
+
+        result.append(value.at(i));
+        i++;
+    }
+
+    result.append(value.mid(i));
+    return result;
+}
+
+K9ShellLexer::K9ShellLexer()
+{
+    begin = nullptr;
+    p = nullptr;
+    end = nullptr;
+    assigned = 0;
+    heredocTabs = false;
+}
+
+bool K9ShellLexer::isNameStart(char c)
+{
+    return isAlpha(c) || c == '_';
+}
+
+bool K9ShellLexer::isNameChar(char c)
+{
+    return isAlpha(c) || isDigit(c) || c == '_';
+}
+
+void K9ShellLexer::parse(const QByteArray& script, const char* const* predefinedNames, const QByteArray* predefinedValues, int predefinedCount, K9Metadata& metadata)
+{
+    begin = script.constData();
+    p = begin;
+    end = begin + script.size();
+    heredoc.clear();
+    values.clear();
+    assigned = 0;
+
+    for(int i = 0; i < predefinedCount; i++)
+    {
+        values.insert(QByteArray(predefinedNames[i]), predefinedValues[i]);
+    }
+
+    const char* nameStart;
+    const char* q;
+    QByteArray name;
+    QByteArray value;
+    while(true)
+    {
+        skipBlanks();
+        if(p >= end)
+        {
+            break;
+        }
+
+        if(isNameStart(*p) == false)
+        {
+            if(*p == '{' || *p == '}' || *p == '(' || *p == ')' || *p == '!')
+            {
+                // grouping or negation, a command follows
+                p++;
+            }
+            else
+            {
+                skipCommand();
+            }
+            continue;
+        }
+
+        nameStart = p;
+        while(p < end && isNameChar(*p))
+        {
+            p++;
+        }
+        name = QByteArray(nameStart, static_cast<int>(p - nameStart));
+
+        if(p < end && *p == '=')
+        {
+            p++;
+            values.insert(name, readWord());
+            assign(name);
+            continue;
+        }
+
+        if(p + 1 < end && *p == '+' && p[1] == '=')
+        {
+            p += 2;
+            value = readWord();
+            values[name].append(value);
+            assign(name);
+            continue;
+        }
+
+        // name() { ... }
+        q = p;
+        while(q < end && (*q == ' ' || *q == '\t'))
+        {
+            q++;
+        }
+        if(q < end && *q == '(')
+        {
+            q++;
+            while(q < end && (*q == ' ' || *q == '\t'))
+            {
+                q++;
+            }
+            if(q < end && *q == ')')
+            {
+                p = q + 1;
+                if(allKeysAssigned())
+                {
+                    break;
+                }
+                skipFunctionBody();
+                continue;
+            }
+        }
+
+        if(name == "function")
+        {
+            skipSpaces();
+            while(p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != '(' && *p != '{')
+            {
+                p++;
+            }
+            skipSpaces();
+            if(p < end && *p == '(')
+            {
+                q = static_cast<const char*>(memchr(p, ')', end - p));
+                p = (q == nullptr) ? end : q + 1;
+            }
+            if(allKeysAssigned())
+            {
+                break;
+            }
+            skipFunctionBody();
+            continue;
+        }
+
+        if(p >= end || *p == ' ' || *p == '\t' || *p == '\n' || *p == ';' || *p == '&' || *p == '|' || *p == ')')
+        {
+            if(isOneOf(name, reservedWords))
+            {
+                continue;
+            }
+
+            if(isOneOf(name, declarationWords))
+            {
+                // skip the options, the assignments are lexed as usual
+                for(;;)
+                {
+                    skipSpaces();
+                    if(p >= end || *p != '-')
+                    {
+                        break;
+                    }
+                    while(p < end && *p != ' ' && *p != '\t' && *p != '\n' && *p != ';')
+                    {
+                        p++;
+                    }
+                }
+                continue;
+            }
+        }
+
+        // some other command (inherit, [[ ]], a function call...)
+        p = nameStart;
+        skipCommand();
+    }
+
+    const char* keyName;
+    for(int key = 0; key < K9Metadata::ebuildKeyCount; key++)
+    {
+        if(assigned & (1u << key))
+        {
+            keyName = K9Metadata::name(static_cast<K9Metadata::Key>(key));
+            metadata.setValue(static_cast<K9Metadata::Key>(key), QString::fromUtf8(values.value(QByteArray::fromRawData(keyName, static_cast<int>(strlen(keyName))))).simplified());
+        }
+    }
+
+    begin = p = end = nullptr;
+}
+
+void K9ShellLexer::assign(const QByteArray& name)
+{
+    const int key = K9Metadata::find(name.constData(), name.size());
+    if(key != -1 && key < K9Metadata::ebuildKeyCount)
+    {
+        assigned |= 1u << key;
+    }
+}
+
+bool K9ShellLexer::allKeysAssigned() const
+{
+    return assigned == (1u << K9Metadata::ebuildKeyCount) - 1;
+}
+
+void K9ShellLexer::advance(int count)
+{
+    p = (end - p < count) ? end : p + count;
+}
+
+bool K9ShellLexer::atWordStart() const
+{
+    return p == begin || (p[-1] != '\0' && strchr(" \t\n;|&(){}", p[-1]) != nullptr);
+}
+
+// Whitespace, newlines, comments and command separators between commands.
+void K9ShellLexer::skipBlanks()
+{
+    char c;
+    while(p < end)
+    {
+        c = *p;
+        if(c == '\n')
+        {
+            p++;
+            if(heredoc.isEmpty() == false)
+            {
+                skipHeredoc();
+            }
+        }
+        else if(c == ' ' || c == '\t' || c == '\r' || c == ';' || c == '&' || c == '|')
+        {
+            p++;
+        }
+        else if(c == '\\' && p + 1 < end && p[1] == '\n')
+        {
+            p += 2;
+        }
+        else if(c == '#')
+        {
+            skipComment();
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+// Spaces and line continuations within a command.
+void K9ShellLexer::skipSpaces()
+{
+    while(p < end)
+    {
+        if(*p == ' ' || *p == '\t')
+        {
+            p++;
+        }
+        else if(*p == '\\' && p + 1 < end && p[1] == '\n')
+        {
+            p += 2;
+        }
+        else
+        {
+            break;
+        }
+    }
+}
+
+void K9ShellLexer::skipComment()
+{
+    const char* q = static_cast<const char*>(memchr(p, '\n', end - p));
+    p = (q == nullptr) ? end : q;
+}
+
+// Skips to the end of a command we don't care about, leaving p on whatever ended it.
+void K9ShellLexer::skipCommand()
+{
+    char c;
+    while(p < end)
+    {
+        c = *p;
+        switch(c)
+        {
+            case '\n':
+            case ';':
+            case '&':
+            case '|':
+            case ')': // also ends a case pattern
+                return;
+
+            case '\\':
+                advance(2);
+                break;
+
+            case '\'':
+                skipSingleQuoted();
+                break;
+
+            case '"':
+                skipDoubleQuoted();
+                break;
+
+            case '`':
+                skipBackticks();
+                break;
+
+            case '$':
+                if(p + 1 < end && (p[1] == '(' || p[1] == '{'))
+                {
+                    c = p[1];
+                    p += 2;
+                    skipNested(c, c == '(' ? ')' : '}');
+                }
+                else
+                {
+                    p++;
+                }
+                break;
+
+            case '(':
+                p++;
+                skipNested('(', ')');
+                break;
+
+            case '#':
+                if(atWordStart())
+                {
+                    skipComment();
+                    return;
+                }
+                p++;
+                break;
+
+            case '<':
+                if(p + 1 < end && p[1] == '<' && (p + 2 >= end || p[2] != '<'))
+                {
+                    p += 2;
+                    readHeredocDelimiter();
+                }
+                else
+                {
+                    p++;
+                }
+                break;
+
+            default:
+                p++;
+                break;
+        }
+    }
+}
+
+void K9ShellLexer::skipSingleQuoted()
+{
+    p++;
+    const char* q = static_cast<const char*>(memchr(p, '\'', end - p));
+    p = (q == nullptr) ? end : q + 1;
+}
+
+void K9ShellLexer::skipDoubleQuoted()
+{
+    char c;
+    p++;
+    while(p < end && *p != '"')
+    {
+        if(*p == '\\')
+        {
+            advance(2);
+        }
+        else if(*p == '`')
+        {
+            skipBackticks();
+        }
+        else if(*p == '$' && p + 1 < end && (p[1] == '(' || p[1] == '{'))
+        {
+            c = p[1];
+            p += 2;
+            skipNested(c, c == '(' ? ')' : '}');
+        }
+        else
+        {
+            p++;
+        }
+    }
+    advance(1);
+}
+
+void K9ShellLexer::skipBackticks()
+{
+    p++;
+    while(p < end && *p != '`')
+    {
+        if(*p == '\\')
+        {
+            advance(2);
+        }
+        else
+        {
+            p++;
+        }
+    }
+    advance(1);
+}
+
+// Skips past the close that balances an open p has just stepped over.
+void K9ShellLexer::skipNested(char open, char close)
+{
+    int depth = 1;
+    char c;
+    while(p < end)
+    {
+        c = *p;
+        if(c == '\\')
+        {
+            advance(2);
+        }
+        else if(c == '\'')
+        {
+            skipSingleQuoted();
+        }
+        else if(c == '"')
+        {
+            skipDoubleQuoted();
+        }
+        else if(c == '`')
+        {
+            skipBackticks();
+        }
+        else if(c == '$' && p + 1 < end && (p[1] == '(' || p[1] == '{'))
+        {
+            c = p[1];
+            p += 2;
+            skipNested(c, c == '(' ? ')' : '}');
+        }
+        else if(c == '#' && atWordStart())
+        {
+            skipComment();
+        }
+        else if(c == '\n')
+        {
+            p++;
+            if(heredoc.isEmpty() == false)
+            {
+                skipHeredoc();
+            }
+        }
+        else if(c == '<' && p + 1 < end && p[1] == '<' && (p + 2 >= end || p[2] != '<'))
+        {
+            p += 2;
+            readHeredocDelimiter();
+        }
+        else
+        {
+            p++;
+            if(c == open)
+            {
+                depth++;
+            }
+            else if(c == close && --depth == 0)
+            {
+                return;
+            }
+        }
+    }
+}
+
+void K9ShellLexer::skipFunctionBody()
+{
+    skipBlanks();
+    if(p >= end)
+    {
+        return;
+    }
+
+    if(*p == '{' || *p == '(')
+    {
+        const char open = *p;
+        p++;
+        skipNested(open, open == '{' ? '}' : ')');
+    }
+    else
+    {
+        skipCommand();
+    }
+}
+
+// The word after << (or <<-); the document itself starts at the next newline.
+void K9ShellLexer::readHeredocDelimiter()
+{
+    heredocTabs = (p < end && *p == '-');
+    if(heredocTabs)
+    {
+        p++;
+    }
+    skipSpaces();
+
+    heredoc.clear();
+    const char* q;
+    while(p < end && strchr(" \t\n;&|<>()", *p) == nullptr)
+    {
+        if(*p == '\'' || *p == '"')
+        {
+            q = static_cast<const char*>(memchr(p + 1, *p, end - p - 1));
+            if(q == nullptr)
+            {
+                q = end;
+            }
+            heredoc.append(p + 1, static_cast<int>(q - p - 1));
+            p = q;
+            advance(1);
+        }
+        else if(*p == '\\')
+        {
+            advance(1);
+            if(p < end)
+            {
+                heredoc.append(*p);
+                p++;
+            }
+        }
+        else
+        {
+            heredoc.append(*p);
+            p++;
+        }
+    }
+}
+
+void K9ShellLexer::skipHeredoc()
+{
+    const QByteArray delimiter = heredoc;
+    heredoc.clear();
+
+    const char* lineEnd;
+    const char* s;
+    bool found;
+    while(p < end)
+    {
+        lineEnd = static_cast<const char*>(memchr(p, '\n', end - p));
+        if(lineEnd == nullptr)
+        {
+            lineEnd = end;
+        }
+
+        s = p;
+        while(heredocTabs && s < lineEnd && *s == '\t')
+        {
+            s++;
+        }
+        found = (lineEnd - s == delimiter.size() && memcmp(s, delimiter.constData(), delimiter.size()) == 0);
+        p = (lineEnd < end) ? lineEnd + 1 : end;
+        if(found)
+        {
+            break;
+        }
+    }
+}
+
+// The value of an assignment, with its quotes removed and expansions done.
+QByteArray K9ShellLexer::readWord()
+{
+    QByteArray out;
+    if(p < end && *p == '(')
+    {
+        // arrays aren't metadata we use
+        p++;
+        skipNested('(', ')');
+        return out;
+    }
+
+    const char* run;
+    while(p < end)
+    {
+        switch(*p)
+        {
+            case ' ':
+            case '\t':
+            case '\r':
+            case '\n':
+            case ';':
+            case '&':
+            case '|':
+            case ')':
+            case '<':
+            case '>':
+                return out;
+
+            case '\\':
+                if(p + 1 < end && p[1] != '\n')
+                {
+                    out.append(p[1]);
+                }
+                advance(2);
+                break;
+
+            case '\'':
+                readSingleQuoted(out);
+                break;
+
+            case '"':
+                readDoubleQuoted(out);
+                break;
+
+            case '`':
+                skipBackticks();
+                break;
+
+            case '$':
+                expand(out);
+                break;
+
+            default:
+                run = p;
+                do
+                {
+                    p++;
+                } while(p < end && strchr(" \t\r\n;&|)<>\\'\"`$", *p) == nullptr);
+                out.append(run, static_cast<int>(p - run));
+                break;
+        }
+    }
+    return out;
+}
+
+void K9ShellLexer::readSingleQuoted(QByteArray& out)
+{
+    p++;
+    const char* q = static_cast<const char*>(memchr(p, '\'', end - p));
+    if(q == nullptr)
+    {
+        q = end;
+    }
+    out.append(p, static_cast<int>(q - p));
+    p = q;
+    advance(1);
+}
+
+void K9ShellLexer::readDoubleQuoted(QByteArray& out)
+{
+    const char* run;
+    char c;
+    p++;
+    while(p < end && *p != '"')
+    {
+        c = *p;
+        if(c == '\\')
+        {
+            if(p + 1 < end)
+            {
+                c = p[1];
+                if(c == '$' || c == '`' || c == '"' || c == '\\')
+                {
+                    out.append(c);
+                }
+                else if(c != '\n')
+                {
+                    out.append('\\');
+                    out.append(c);
+                }
+            }
+            advance(2);
+        }
+        else if(c == '$')
+        {
+            expand(out);
+        }
+        else if(c == '`')
+        {
+            skipBackticks();
+        }
+        else
+        {
+            // strings spanning several lines come through as one run
+            run = p;
+            while(p < end && *p != '"' && *p != '\\' && *p != '$' && *p != '`')
+            {
+                p++;
+            }
+            out.append(run, static_cast<int>(p - run));
+        }
+    }
+    advance(1);
+}
+
+// The word after the operator in ${VAR...}, up to the closing brace (which is consumed) or,
+// with stopAtSlash, the '/' before a replacement (which isn't). Quoted characters in a
+// pattern are escaped so they match literally.
+void K9ShellLexer::readBraceArgument(QByteArray& out, bool pattern, bool stopAtSlash)
+{
+    QByteArray quoted;
+    char c;
+    while(p < end)
+    {
+        c = *p;
+        if(c == '}')
+        {
+            p++;
+            return;
+        }
+
+        if(stopAtSlash && c == '/')
+        {
+            return;
+        }
+
+        if(c == '\\')
+        {
+            if(p + 1 < end && p[1] != '\n')
+            {
+                if(pattern)
+                {
+                    out.append('\\');
+                }
+                out.append(p[1]);
+            }
+            advance(2);
+        }
+        else if(c == '\'' || c == '"')
+        {
+            quoted.clear();
+            if(c == '\'')
+            {
+                readSingleQuoted(quoted);
+            }
+            else
+            {
+                readDoubleQuoted(quoted);
+            }
+
+            if(pattern)
+            {
+                for(int i = 0; i < quoted.size(); i++)
+                {
+                    if(strchr("*?[\\", quoted.at(i)) != nullptr)
+                    {
+                        out.append('\\');
+                    }
+                    out.append(quoted.at(i));
+                }
+            }
+            else
+            {
+                out.append(quoted);
+            }
+        }
+        else if(c == '$')
+        {
+            expand(out);
+        }
+        else if(c == '`')
+        {
+            skipBackticks();
+        }
+        else
+        {
+            out.append(c);
+            p++;
+        }
+    }
+}
+
+// $VAR, ${...}, $(...) and the rest, starting at the '$'.
+void K9ShellLexer::expand(QByteArray& out)
+{
+    if(p + 1 >= end)
+    {
+        out.append('$');
+        p++;
+        return;
+    }
+
+    const char c = p[1];
+    const char* start;
+    if(c == '{')
+    {
+        p += 2;
+        expandParameter(out);
+    }
+    else if(c == '(')
+    {
+        start = p + 2;
+        const bool arithmetic = (start < end && *start == '(');
+        p += 2;
+        skipNested('(', ')');
+        if(arithmetic == false)
+        {
+            expandCommand(out, start, p - 1);
+        }
+    }
+    else if(isNameStart(c))
+    {
+        p++;
+        start = p;
+        while(p < end && isNameChar(*p))
+        {
+            p++;
+        }
+        out.append(values.value(QByteArray::fromRawData(start, static_cast<int>(p - start))));
+    }
+    else if(c == '\'')
+    {
+        p++;
+        readSingleQuoted(out);
+    }
+    else if(c == '"')
+    {
+        p++;
+        readDoubleQuoted(out);
+    }
+    else if(isDigit(c) || strchr("@*#?$!-", c) != nullptr)
+    {
+        // positional and special parameters are empty at global scope
+        advance(2);
+    }
+    else
+    {
+        out.append('$');
+        p++;
+    }
+}
+
+// ${VAR}, ${#VAR}, ${VAR:-word}, ${VAR%pattern}, ${VAR/pattern/word}, ${VAR^^}, ${VAR:1:2}...
+// p is just past the "${".
+void K9ShellLexer::expandParameter(QByteArray& out)
+{
+    bool length = false;
+    if(p + 1 < end && *p == '#' && p[1] != '}')
+    {
+        length = true;
+        p++;
+    }
+
+    const char* start = p;
+    if(p < end && isNameStart(*p))
+    {
+        while(p < end && isNameChar(*p))
+        {
+            p++;
+        }
+    }
+    else if(p < end)
+    {
+        p++;
+    }
+    const QByteArray name(start, static_cast<int>(p - start));
+    QHash<QByteArray, QByteArray>::const_iterator it = values.constFind(name);
+    const bool set = (it != values.constEnd());
+    const QByteArray value = set ? it.value() : QByteArray();
+
+    if(p < end && *p == '[')
+    {
+        // ${ARRAY[@]} and friends, treated like the scalar
+        const char* q = static_cast<const char*>(memchr(p, ']', end - p));
+        p = (q == nullptr) ? end : q + 1;
+    }
+
+    QByteArray word;
+    QByteArray replacement;
+    if(length)
+    {
+        readBraceArgument(word, false, false);
+        out.append(QByteArray::number(value.size()));
+        return;
+    }
+
+    if(p >= end)
+    {
+        out.append(value);
+        return;
+    }
+
+    char op = *p;
+    switch(op)
+    {
+        case '}':
+            p++;
+            out.append(value);
+            break;
+
+        case ':':
+            p++;
+            if(p < end && *p != '\0' && strchr("-=+?", *p) != nullptr)
+            {
+                op = *p;
+                p++;
+                readBraceArgument(word, false, false);
+                if(op == '+')
+                {
+                    out.append(value.isEmpty() ? QByteArray() : word);
+                }
+                else if(op == '-' || op == '=')
+                {
+                    out.append(value.isEmpty() ? word : value);
+                    if(op == '=' && value.isEmpty())
+                    {
+                        values.insert(name, word);
+                    }
+                }
+                else
+                {
+                    out.append(value);
+                }
+            }
+            else
+            {
+                // ${VAR:offset} and ${VAR:offset:length}
+                readBraceArgument(word, false, false);
+                QList<QByteArray> range = word.split(':');
+                const int size = static_cast<int>(value.size());
+                int offset = range.at(0).trimmed().toInt();
+                if(offset < 0)
+                {
+                    offset = qMax(0, size + offset);
+                }
+                offset = qMin(offset, size);
+                int count = size - offset;
+                if(range.count() > 1)
+                {
+                    count = range.at(1).trimmed().toInt();
+                    if(count < 0)
+                    {
+                        count = qMax(0, size - offset + count);
+                    }
+                }
+                out.append(value.mid(offset, count));
+            }
+            break;
+
+        case '-':
+        case '=':
+        case '+':
+        case '?':
+            p++;
+            readBraceArgument(word, false, false);
+            if(op == '+')
+            {
+                out.append(set ? word : QByteArray());
+            }
+            else if(op == '-' || op == '=')
+            {
+                out.append(set ? value : word);
+                if(op == '=' && set == false)
+                {
+                    values.insert(name, word);
+                }
+            }
+            else
+            {
+                out.append(value);
+            }
+            break;
+
+        case '%':
+        case '#':
+        {
+            p++;
+            const bool longest = (p < end && *p == op);
+            if(longest)
+            {
+                p++;
+            }
+            readBraceArgument(word, true, false);
+            out.append(removePattern(value, word, op == '%', longest));
+            break;
+        }
+
+        case '/':
+        {
+            p++;
+            char mode = '/';
+            if(p < end && (*p == '/' || *p == '#' || *p == '%'))
+            {
+                mode = (*p == '/') ? 'a' : *p;
+                p++;
+            }
+            readBraceArgument(word, true, true);
+            if(p < end && *p == '/')
+            {
+                p++;
+                readBraceArgument(replacement, false, false);
+            }
+            out.append(replacePattern(value, word, replacement, mode));
+            break;
+        }
+
+        case '^':
+        case ',':
+        {
+            p++;
+            const bool all = (p < end && *p == op);
+            if(all)
+            {
+                p++;
+            }
+            readBraceArgument(word, true, false);
+            if(all)
+            {
+                out.append(op == '^' ? value.toUpper() : value.toLower());
+            }
+            else if(value.isEmpty() == false)
+            {
+                out.append(op == '^' ? value.left(1).toUpper() : value.left(1).toLower());
+                out.append(value.mid(1));
+            }
+            break;
+        }
+
+        default:
+            readBraceArgument(word, false, false);
+            out.append(value);
+            break;
+    }
+}
+
+// $(...) between start and stop. Only the version helpers ebuilds use in their metadata
+// are understood; anything else expands to nothing.
+void K9ShellLexer::expandCommand(QByteArray& out, const char* start, const char* stop)
+{
+    const char* savedBegin = begin;
+    const char* savedP = p;
+    const char* savedEnd = end;
+    begin = start;
+    p = start;
+    end = stop;
+
+    QList<QByteArray> words;
+    QByteArray word;
+    for(;;)
+    {
+        skipSpaces();
+        if(p >= end || strchr("\n;&|", *p) != nullptr)
+        {
+            break;
+        }
+        start = p;
+        word = readWord();
+        if(p == start)
+        {
+            // a redirection or something else that isn't a word
+            break;
+        }
+        words.append(word);
+    }
+
+    begin = savedBegin;
+    p = savedP;
+    end = savedEnd;
+
+    if(words.isEmpty())
+    {
+        return;
+    }
+
+    const QByteArray& command = words.first();
+    if(command == "ver_cut" || command == "get_version_component_range")
+    {
+        if(words.count() > 1)
+        {
+            out.append(verCut(words.at(1), words.count() > 2 ? words.at(2) : values.value("PV")));
+        }
+    }
+    else if(command == "ver_rs")
+    {
+        out.append(verRs(words.mid(1), values.value("PV")));
+    }
+}
+
+// Splits a version the way PMS does for ver_cut and ver_rs: separator 0, component 1,
+// separator 1, component 2... Components are runs of digits or of letters; anything
+// else separates them, and a digit next to a letter has an empty separator between.
+QList<QByteArray> K9ShellLexer::versionParts(const QByteArray& version)
+{
+    QList<QByteArray> parts;
+    const int n = version.size();
+    int i = 0;
+    int j = 0;
+    while(j < n && isAlpha(version.at(j)) == false && isDigit(version.at(j)) == false)
+    {
+        j++;
+    }
+    parts.append(version.left(j));
+    i = j;
+
+    while(i < n)
+    {
+        j = i;
+        if(isDigit(version.at(j)))
+        {
+            while(j < n && isDigit(version.at(j)))
+            {
+                j++;
+            }
+        }
+        else
+        {
+            while(j < n && isAlpha(version.at(j)))
+            {
+                j++;
+            }
+        }
+        parts.append(version.mid(i, j - i));
+
+        i = j;
+        while(j < n && isAlpha(version.at(j)) == false && isDigit(version.at(j)) == false)
+        {
+            j++;
+        }
+        parts.append(version.mid(i, j - i));
+        i = j;
+    }
+    return parts;
+}
+
+// "N", "N-M" or "N-" (through the end)
+bool K9ShellLexer::versionRange(const QByteArray& range, int& first, int& last)
+{
+    bool ok;
+    const int dash = range.indexOf('-');
+    if(dash == -1)
+    {
+        first = range.toInt(&ok);
+        last = first;
+        return ok;
+    }
+
+    first = range.left(dash).toInt(&ok);
+    if(ok == false)
+    {
+        return false;
+    }
+
+    if(dash == range.size() - 1)
+    {
+        last = INT_MAX;
+        return true;
+    }
+
+    last = range.mid(dash + 1).toInt(&ok);
+    return ok;
+}
+
+QByteArray K9ShellLexer::verCut(const QByteArray& range, const QByteArray& version)
+{
+    int first;
+    int last;
+    if(versionRange(range, first, last) == false)
+    {
+        return QByteArray();
+    }
+
+    const QList<QByteArray> parts = versionParts(version);
+    const int count = parts.count() / 2;
+    last = qMin(last, count);
+    if(first < 0 || first > last)
+    {
+        return QByteArray();
+    }
+
+    QByteArray result;
+    const int from = (first == 0) ? 0 : first * 2 - 1;
+    const int to = (last == 0) ? 0 : last * 2 - 1;
+    for(int i = from; i <= to; i++)
+    {
+        result.append(parts.at(i));
+    }
+    return result;
+}
+
+// ver_rs range separator [range separator...] [version]
+QByteArray K9ShellLexer::verRs(const QList<QByteArray>& args, const QByteArray& version)
+{
+    QList<QByteArray> parts = versionParts((args.count() % 2) ? args.last() : version);
+    const int count = parts.count() / 2;
+    int first;
+    int last;
+    for(int k = 0; k + 1 < args.count(); k += 2)
+    {
+        if(versionRange(args.at(k), first, last) == false)
+        {
+            continue;
+        }
+
+        last = qMin(last, count);
+        for(int i = qMax(first, 0); i <= last; i++)
+        {
+            // the separators before the first and after the last component only exist when the version has them
+            if((i == 0 || i == count) && parts.at(i * 2).isEmpty())
+            {
+                continue;
+            }
+            parts[i * 2] = args.at(k + 1);
+        }
+    }
+
+    QByteArray result;
+    for(int i = 0; i < parts.count(); i++)
+    {
+        result.append(parts.at(i));
+    }
+    return result;
+}
@@ -0,0 +1,85 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9SHELLLEXER_H
+#define K9SHELLLEXER_H
+
+#include "k9metadata.h"
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+// Reads the global variable assignments out of an ebuild in a single pass over its
+// bytes, the way bash would see them: quoting, line continuations, strings spanning
+// several lines, ${VAR}, ${VAR%pattern} style expansions and $(ver_cut)/$(ver_rs).
+// Everything else is skipped over, including the bodies of functions, so an
+// assignment inside src_prepare() doesn't leak into the package's metadata. Branches
+// aren't evaluated; like portage's own regen, the last assignment to a variable wins.
+class K9ShellLexer
+{
+public:
+    K9ShellLexer();
+
+    // The predefined read-only variables (PN, PV, ...) can be expanded by the script. Every
+    // K9Metadata key the script assigns at global scope is written to metadata with its
+    // whitespace collapsed, the way md5-cache stores it. Lexing stops at the first function
+    // definition after all of the keys an ebuild sets have been assigned.
+    void parse(const QByteArray& script, const char* const* predefinedNames, const QByteArray* predefinedValues, int predefinedCount, K9Metadata& metadata);
+
+private:
+    const char* begin;
+    const char* p;
+    const char* end;
+    QHash<QByteArray, QByteArray> values;
+    unsigned int assigned; // bit per K9Metadata::Key the script has assigned
+    QByteArray heredoc; // delimiter of a here-document that starts at the next newline
+    bool heredocTabs; // <<- strips leading tabs
+
+    void assign(const QByteArray& name);
+    bool allKeysAssigned(void) const;
+    void advance(int count);
+    bool atWordStart(void) const;
+    void skipBlanks(void);
+    void skipSpaces(void);
+    void skipComment(void);
+    void skipCommand(void);
+    void skipSingleQuoted(void);
+    void skipDoubleQuoted(void);
+    void skipBackticks(void);
+    void skipNested(char open, char close);
+    void skipFunctionBody(void);
+    void readHeredocDelimiter(void);
+    void skipHeredoc(void);
+
+    QByteArray readWord(void);
+    void readSingleQuoted(QByteArray& out);
+    void readDoubleQuoted(QByteArray& out);
+    void readBraceArgument(QByteArray& out, bool pattern, bool stopAtSlash);
+    void expand(QByteArray& out);
+    void expandParameter(QByteArray& out);
+    void expandCommand(QByteArray& out, const char* start, const char* stop);
+
+    static bool isNameStart(char c);
+    static bool isNameChar(char c);
+    static QList<QByteArray> versionParts(const QByteArray& version);
+    static bool versionRange(const QByteArray& range, int& first, int& last);
+    static QByteArray verCut(const QByteArray& range, const QByteArray& version);
+    static QByteArray verRs(const QList<QByteArray>& args, const QByteArray& version);
+};
+
+#endif // K9SHELLLEXER_H
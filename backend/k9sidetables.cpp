@@ -0,0 +1,134 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9sidetables.h"
+#include "globals.h"
+
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QVariant>
+
+const char* const sideTableNames[K9SideTables::tableCount] = { "DESCRIPTION", "HOMEPAGE", "KEYWORDS", "IUSE", "LICENSE" };
+
+K9SideTables::K9SideTables()
+{
+    for(int i = 0; i < tableCount; i++)
+    {
+        inserts[i] = nullptr;
+    }
+}
+
+K9SideTables::~K9SideTables()
+{
+    clear();
+}
+
+// Reads every side table into memory and prepares the inserts for values we haven't seen yet.
+bool K9SideTables::load(QSqlDatabase& db)
+{
+    clear();
+
+    QSqlQuery query(db);
+    query.setForwardOnly(true);
+    for(int i = 0; i < tableCount; i++)
+    {
+        if(query.exec(QString("select %1ID, %1 from %1").arg(sideTableNames[i])) == false)
+        {
+            output << "Couldn't read " << sideTableNames[i] << ": " << query.lastError().text() << Qt::endl;
+            return false;
+        }
+
+        while(query.next())
+        {
+            ids[i].insert(query.value(1).toString(), query.value(0).toLongLong());
+        }
+
+        inserts[i] = new QSqlQuery(db);
+        inserts[i]->prepare(QString("insert into %1 (%1) values(?)").arg(sideTableNames[i]));
+    }
+
+    return true;
+}
+
+void K9SideTables::clear()
+{
+    for(int i = 0; i < tableCount; i++)
+    {
+        ids[i].clear();
+        delete inserts[i];
+        inserts[i] = nullptr;
+    }
+}
+
+// Binds the id of value at placeholder, adding value to the table first if it's new.
+// Empty values bind NULL.
+bool K9SideTables::bind(QSqlQuery* query, int placeholder, Table table, const QString& value)
+{
+    if(value.isEmpty())
+    {
+#if QT_VERSION < 0x060000
+        query->bindValue(placeholder, QVariant(QVariant::LongLong));
+#else
+        query->bindValue(placeholder, QVariant(QMetaType::fromType<qint64>()));
+#endif
+        return true;
+    }
+
+    QHash<QString, qint64>::const_iterator it = ids[table].constFind(value);
+    if(it != ids[table].constEnd())
+    {
+        query->bindValue(placeholder, it.value());
+        return true;
+    }
+
+    QSqlQuery* insert = inserts[table];
+    if(insert == nullptr)
+    {
+        return false;
+    }
+
+    insert->bindValue(0, value);
+    if(insert->exec() == false)
+    {
+        output << "Query failed:" << insert->executedQuery() << insert->lastError().text() << Qt::endl;
+        return false;
+    }
+
+    const qint64 id = insert->lastInsertId().toLongLong();
+    ids[table].insert(value, id);
+    query->bindValue(placeholder, id);
+    return true;
+}
+
+// Deletes the strings no PACKAGE row refers to anymore. Forgets the cached ids,
+// so call load() again before binding more rows.
+bool K9SideTables::prune(QSqlQuery& query)
+{
+    clear();
+
+    for(int i = 0; i < tableCount; i++)
+    {
+        // "not in" a list holding a NULL is never true, so leave those out
+        if(query.exec(QString("delete from %1 where %1ID not in (select %1ID from PACKAGE where %1ID is not null)").arg(sideTableNames[i])) == false)
+        {
+            output << "Couldn't prune " << sideTableNames[i] << ": " << query.lastError().text() << Qt::endl;
+            return false;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9SIDETABLES_H
+#define K9SIDETABLES_H
+
+#include <QString>
+#include <QHash>
+
+class QSqlDatabase;
+class QSqlQuery;
+
+// Hands out ids for the DESCRIPTION, HOMEPAGE, KEYWORDS, IUSE and LICENSE side
+// tables, so PACKAGE stores each distinct string once instead of once per version.
+// Only the database writer thread may use it.
+class K9SideTables
+{
+public:
+    enum Table
+    {
+        description = 0,
+        homepage,
+        keywords,
+        iuse,
+        license,
+        tableCount
+    };
+
+    K9SideTables();
+    ~K9SideTables();
+
+    bool load(QSqlDatabase& db);
+    void clear(void);
+    bool bind(QSqlQuery* query, int placeholder, Table table, const QString& value);
+    bool prune(QSqlQuery& query);
+
+private:
+    QHash<QString, qint64> ids[tableCount];
+    QSqlQuery* inserts[tableCount];
+
+    K9SideTables(const K9SideTables&) = delete;
+    K9SideTables& operator=(const K9SideTables&) = delete;
+};
+
+#endif // K9SIDETABLES_H
@@ -0,0 +1,113 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9sqlfunctions.h"
+#include "k9atom.h"
+#include "versionstring.h"
+
+#include <QSqlDriver>
+#include <QVariant>
+#include <QAtomicInt>
+#include <QDebug>
+
+#ifndef K9_BUNDLED_SQLITE
+#include <sqlite3.h>
+
+static QString text(sqlite3_value* value)
+{
+    // sqlite3_value_bytes() is only meaningful after sqlite3_value_text() has converted the value
+    const char* s = reinterpret_cast<const char*>(sqlite3_value_text(value));
+    return QString::fromUtf8(s, sqlite3_value_bytes(value));
+}
+
+static void deleteAtom(void* atom)
+{
+    delete static_cast<K9Atom*>(atom);
+}
+
+static void atomMatch(sqlite3_context* context, int argc, sqlite3_value** argv)
+{
+    Q_UNUSED(argc);
+    if(sqlite3_value_type(argv[0]) == SQLITE_NULL)
+    {
+        sqlite3_result_null(context);
+        return;
+    }
+
+    // the atom is usually the same for every row of a statement, so only parse it once
+    K9Atom* atom = static_cast<K9Atom*>(sqlite3_get_auxdata(context, 0));
+    if(atom == nullptr)
+    {
+        atom = new K9Atom(text(argv[0]));
+        sqlite3_set_auxdata(context, 0, atom, deleteAtom);
+        atom = static_cast<K9Atom*>(sqlite3_get_auxdata(context, 0)); // SQLite may have had to let it go already
+        if(atom == nullptr)
+        {
+            sqlite3_result_error_nomem(context);
+            return;
+        }
+    }
+
+    if(atom->type == K9Atom::Unknown ||
+       atom->globMatch(atom->category, text(argv[1])) == false ||
+       atom->globMatch(atom->package, text(argv[2])) == false)
+    {
+        sqlite3_result_int(context, 0);
+        return;
+    }
+
+    VersionString version;
+    version.parse(text(argv[3]));
+    sqlite3_result_int(context, atom->isMatch(text(argv[4]), text(argv[5]), version) ? 1 : 0);
+}
+#endif
+
+// Views open a connection each, so only the first failure is worth telling anyone about.
+static QAtomicInt warned;
+
+static bool unavailable(const QSqlDatabase& db, const QString& reason)
+{
+    if(warned.testAndSetRelaxed(0, 1))
+    {
+        qDebug() << "SQL functions not installed on" << db.connectionName() << ":" << reason;
+    }
+    return false;
+}
+
+bool K9SqlFunctions::install(QSqlDatabase& db)
+{
+#ifdef K9_BUNDLED_SQLITE
+    return unavailable(db, "built with CONFIG+=bundled_sqlite");
+#else
+    QVariant handle = db.driver()->handle();
+    if(handle.isValid() == false || qstrcmp(handle.typeName(), "sqlite3*") != 0)
+    {
+        return unavailable(db, "not a SQLite connection");
+    }
+
+    sqlite3* connection = *static_cast<sqlite3**>(handle.data());
+    if(connection == nullptr)
+    {
+        return unavailable(db, "connection isn't open");
+    }
+
+    if(sqlite3_create_function(connection, "atom_match", 6, SQLITE_UTF8 | SQLITE_DETERMINISTIC, nullptr, atomMatch, nullptr, nullptr) != SQLITE_OK)
+    {
+        return unavailable(db, QString::fromUtf8(sqlite3_errmsg(connection)));
+    }
+    return true;
+#endif
+}
@@ -0,0 +1,39 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9SQLFUNCTIONS_H
+#define K9SQLFUNCTIONS_H
+
+#include <QSqlDatabase>
+
+// Native SQLite functions, so queries can match atoms inside the engine:
+//
+//   atom_match(atom, category, package, version, slot, subslot)
+//                  1 when the package.mask style atom matches the package, else 0
+//
+// SQLite forgets functions when the connection closes, so install() again after every open().
+//
+// The functions are handed to the driver's sqlite3 handle through this program's libsqlite3, so
+// the .pro files refuse to build unless the QSQLITE plugin links that same system library. Built
+// with CONFIG+=bundled_sqlite instead, install() always returns false and callers fall back to
+// doing without.
+class K9SqlFunctions
+{
+public:
+    static bool install(QSqlDatabase& db);
+};
+
+#endif // K9SQLFUNCTIONS_H
@@ -0,0 +1,156 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9stats.h"
+
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutexLocker>
+
+static const char* const phaseNames[K9Stats::phaseCount] = { "enumerate", "read", "parse", "masks", "sql" };
+
+K9Stats::K9Stats(const QString& vdbFolder, const QStringList& repos)
+{
+    sources.append(QString());
+    sources.append(vdbFolder);
+    sources.append(repos);
+    counters = new Counter[sources.count() * phaseCount];
+    wallTimer.start();
+}
+
+K9Stats::~K9Stats()
+{
+    delete[] counters;
+}
+
+void K9Stats::add(Phase phase, int source, qint64 nsecs)
+{
+    counters[phase].nsecs += nsecs;
+    counters[phase].calls++;
+
+    const int slot = source + 2;
+    if(source != noSource && slot < sources.count())
+    {
+        Counter& counter = counters[slot * phaseCount + phase];
+        counter.nsecs += nsecs;
+        counter.calls++;
+    }
+}
+
+void K9Stats::addPackage(int source, const QString& package, qint64 nsecs)
+{
+    if(nsecs <= slowThreshold)
+    {
+        return;
+    }
+
+    QMutexLocker lock(&slowMutex);
+    int i = 0;
+    while(i < slowPackages.count() && slowPackages.at(i).nsecs >= nsecs)
+    {
+        i++;
+    }
+
+    SlowPackage slow;
+    slow.source = source;
+    slow.package = package;
+    slow.nsecs = nsecs;
+    slowPackages.insert(i, slow);
+    if(slowPackages.count() > slowPackageCount)
+    {
+        slowPackages.removeLast();
+        slowThreshold = slowPackages.last().nsecs;
+    }
+}
+
+QByteArray K9Stats::toJson(qint64 rowsChanged, int jobs) const
+{
+    QJsonObject report;
+    report.insert("wallSeconds", wallTimer.nsecsElapsed() / 1e9);
+    report.insert("jobs", jobs);
+    report.insert("rowsChanged", rowsChanged);
+
+    QJsonArray bySource;
+    QJsonObject phases;
+    QJsonObject phase;
+    int slot;
+    int i;
+    for(slot = 0; slot < sources.count(); slot++)
+    {
+        phases = QJsonObject();
+        for(i = 0; i < phaseCount; i++)
+        {
+            const Counter& counter = counters[slot * phaseCount + i];
+            phase = QJsonObject();
+            phase.insert("threadSeconds", counter.nsecs / 1e9);
+            phase.insert("calls", static_cast<qint64>(counter.calls));
+            phases.insert(phaseNames[i], phase);
+        }
+
+        if(slot == 0)
+        {
+            report.insert("totals", phases);
+        }
+        else
+        {
+            phases.insert("source", sources.at(slot));
+            bySource.append(phases);
+        }
+    }
+    report.insert("sources", bySource);
+
+    QJsonArray slowest;
+    QJsonObject package;
+    QMutexLocker lock(&slowMutex);
+    for(i = 0; i < slowPackages.count(); i++)
+    {
+        const SlowPackage& slow = slowPackages.at(i);
+        package = QJsonObject();
+        package.insert("source", sources.value(slow.source + 2));
+        package.insert("package", slow.package);
+        package.insert("milliseconds", slow.nsecs / 1e6);
+        slowest.append(package);
+    }
+    report.insert("slowestPackages", slowest);
+
+    return QJsonDocument(report).toJson(QJsonDocument::Indented);
+}
+
+K9Stats::Timer::Timer(K9Stats* stats, Phase phase, int source)
+{
+    this->stats = stats;
+    this->phase = phase;
+    this->source = source;
+    if(stats)
+    {
+        timer.start();
+    }
+}
+
+K9Stats::Timer::~Timer()
+{
+    stop();
+}
+
+void K9Stats::Timer::stop()
+{
+    if(stats)
+    {
+        stats->add(phase, source, timer.nsecsElapsed());
+        stats = nullptr;
+    }
+}
@@ -0,0 +1,97 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9STATS_H
+#define K9STATS_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QList>
+
+#include <atomic>
+
+// Where an import spends its time, collected from every worker thread for the -stats
+// report. Times are summed across threads, so with -jobs they add up to more than the
+// wall clock time. Sources are ImportVDB's repo indexes, with -1 for /var/db/pkg.
+class K9Stats
+{
+public:
+    enum Phase
+    {
+        enumerate = 0, // listing folders
+        read, // opening and reading small files (md5-cache stamps, /var/db/pkg entries)
+        parse, // ebuild and md5-cache readers, version regexes
+        masks, // applyKeywordMasks and applyConfigMasks
+        sql, // QSqlQuery::exec
+        phaseCount
+    };
+
+    static const int noSource = -2; // counts towards the totals only
+
+    K9Stats(const QString& vdbFolder, const QStringList& repos);
+    ~K9Stats();
+
+    void add(Phase phase, int source, qint64 nsecs);
+    void addPackage(int source, const QString& package, qint64 nsecs);
+    QByteArray toJson(qint64 rowsChanged, int jobs) const;
+
+    // Adds the time between construction and destruction to a phase; does nothing when stats is null.
+    class Timer
+    {
+    public:
+        Timer(K9Stats* stats, Phase phase, int source = noSource);
+        ~Timer();
+        void stop(void); // adds the time now instead of at destruction
+
+    private:
+        K9Stats* stats;
+        Phase phase;
+        int source;
+        QElapsedTimer timer;
+    };
+
+private:
+    struct Counter
+    {
+        std::atomic<qint64> nsecs{0};
+        std::atomic<qint64> calls{0};
+    };
+
+    struct SlowPackage
+    {
+        int source;
+        QString package;
+        qint64 nsecs;
+    };
+
+    static const int slowPackageCount = 20;
+
+    QStringList sources; // slot 1 is /var/db/pkg, slot 2 onwards the repos; slot 0 holds the totals
+    Counter* counters; // sources.count() + 1 slots of phaseCount counters
+    QElapsedTimer wallTimer;
+
+    mutable QMutex slowMutex;
+    QList<SlowPackage> slowPackages; // slowest first
+    std::atomic<qint64> slowThreshold{0}; // skip the mutex for packages faster than the slowest we're keeping
+
+    K9Stats(const K9Stats&) = delete;
+    K9Stats& operator=(const K9Stats&) = delete;
+};
+
+#endif // K9STATS_H
@@ -0,0 +1,335 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9watcher.h"
+#include "k9portage.h"
+#include "importvdb.h"
+#include "globals.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSocketNotifier>
+#include <QRegularExpression>
+#include <QStringList>
+
+#include <sys/inotify.h>
+#include <signal.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+const QRegularExpression packageFolderRE = QRegularExpression(QStringLiteral("(.+)-([0-9][0-9,\\-,\\.,[A-z]*)"));
+
+const uint32_t folderMask = IN_CREATE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+const uint32_t fileMask = IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO | IN_ONLYDIR;
+
+const int debounceMilliseconds = 2000;
+const int maxReloadAppPackages = 200; // past this, an incremental reloadDatabase() is cheaper than reloadApp()
+
+K9Watcher::K9Watcher(QObject *parent) : QObject(parent)
+{
+    jobs = 1;
+    pid = -1;
+    inotifyFd = -1;
+    notifier = nullptr;
+    pendingReload = false;
+
+    debounce.setSingleShot(true);
+    debounce.setInterval(debounceMilliseconds);
+    connect(&debounce, &QTimer::timeout, this, &K9Watcher::applyChanges);
+}
+
+K9Watcher::~K9Watcher()
+{
+    if(inotifyFd != -1)
+    {
+        ::close(inotifyFd);
+    }
+}
+
+bool K9Watcher::start()
+{
+    inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if(inotifyFd == -1)
+    {
+        output << "Couldn't initialize inotify: " << strerror(errno) << Qt::endl;
+        return false;
+    }
+
+    QDir dir;
+    QString s;
+
+    addWatch(installedRoot, portage->vdbFolder);
+    dir.setPath(portage->vdbFolder);
+    foreach(s, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        addWatch(installedCategory, portage->vdbFolder + s, s);
+    }
+
+    const int repoCount = portage->repos.count();
+    for(int i = 0; i < repoCount; i++)
+    {
+        watchRepo(portage->repos.at(i));
+    }
+
+    addWatch(configFolder, portage->configFolder);
+    dir.setPath(portage->configFolder);
+    foreach(s, dir.entryList(QStringList("package.*"), QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        addWatch(configFolder, portage->configFolder + s);
+    }
+
+    output << "Watching " << watches.count() << " folders." << Qt::endl;
+
+    notifier = new QSocketNotifier(inotifyFd, QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, &K9Watcher::readEvents);
+
+    // catch up on anything that changed while nobody was watching
+    pendingReload = true;
+    QTimer::singleShot(0, this, &K9Watcher::applyChanges);
+    return true;
+}
+
+void K9Watcher::watchRepo(QString repoFolder)
+{
+    QDir dir;
+    QDir packages;
+    QString category;
+    QString package;
+    QString metaCacheFolder = QString("%1metadata/md5-cache").arg(repoFolder);
+
+    if(QFileInfo(metaCacheFolder).isDir())
+    {
+        // the cache is regenerated for every ebuild that changes, so it's all we need to watch
+        addWatch(metaCacheRoot, metaCacheFolder);
+        dir.setPath(metaCacheFolder);
+        foreach(category, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            addWatch(metaCacheCategory, QString("%1/%2").arg(metaCacheFolder, category), category);
+        }
+        return;
+    }
+
+    addWatch(repoRoot, repoFolder);
+    dir.setPath(repoFolder);
+    foreach(category, dir.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        addWatch(repoCategory, repoFolder + category, category);
+        packages.setPath(repoFolder + category);
+        foreach(package, packages.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+        {
+            addWatch(repoPackage, QString("%1%2/%3").arg(repoFolder, category, package), category, package);
+        }
+    }
+}
+
+void K9Watcher::addWatch(WatchType type, QString path, QString category, QString package)
+{
+    uint32_t mask;
+    switch(type)
+    {
+        case metaCacheCategory:
+        case repoPackage:
+        case configFolder:
+            mask = fileMask;
+            break;
+
+        default:
+            mask = folderMask;
+            break;
+    }
+
+    int wd = inotify_add_watch(inotifyFd, QFile::encodeName(path).constData(), mask);
+    if(wd == -1)
+    {
+        output << "Couldn't watch " << path << ": " << strerror(errno) << Qt::endl;
+        return;
+    }
+
+    WatchPoint watchPoint;
+    watchPoint.type = type;
+    watchPoint.path = path;
+    watchPoint.category = category;
+    watchPoint.package = package;
+    watches.insert(wd, watchPoint);
+}
+
+void K9Watcher::readEvents()
+{
+    alignas(struct inotify_event) char buffer[65536];
+    const struct inotify_event* event;
+    ssize_t length;
+    char* p;
+
+    while((length = ::read(inotifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        for(p = buffer; p < buffer + length; p += sizeof(struct inotify_event) + event->len)
+        {
+            event = reinterpret_cast<const struct inotify_event*>(p);
+            handleEvent(event);
+        }
+    }
+
+    // wait for things to settle down; emerge --sync touches thousands of files in a row
+    debounce.start();
+}
+
+void K9Watcher::handleEvent(const struct inotify_event* event)
+{
+    if(event->mask & IN_Q_OVERFLOW)
+    {
+        pendingReload = true;
+        return;
+    }
+
+    QHash<int, WatchPoint>::iterator it = watches.find(event->wd);
+    if(it == watches.end())
+    {
+        return;
+    }
+
+    if(event->mask & IN_IGNORED)
+    {
+        // folder was deleted (or unmounted)
+        watches.erase(it);
+        return;
+    }
+
+    QString name;
+    if(event->len)
+    {
+        name = QFile::decodeName(event->name);
+    }
+
+    // skip rsync's temporary files and portage's half merged packages
+    if(name.isEmpty() || name.startsWith('.') || name.startsWith("-MERGING-"))
+    {
+        return;
+    }
+
+    const WatchPoint watchPoint = it.value();
+    const bool newFolder = (event->mask & IN_ISDIR) && (event->mask & (IN_CREATE | IN_MOVED_TO));
+    QString s;
+    switch(watchPoint.type)
+    {
+        case installedRoot:
+        case metaCacheRoot:
+        case repoRoot:
+            if(newFolder)
+            {
+                // a brand new category needs a CATEGORY row, which only reloadDatabase() hands out
+                pendingReload = true;
+                addWatch(watchPoint.type == installedRoot ? installedCategory : (watchPoint.type == metaCacheRoot ? metaCacheCategory : repoCategory),
+                         QString("%1/%2").arg(watchPoint.path, name), name);
+            }
+            break;
+
+        case installedCategory:
+        case metaCacheCategory:
+            s = packageName(name);
+            if(s.isEmpty() == false)
+            {
+                pendingPackages.insert(QString("%1/%2").arg(watchPoint.category, s));
+            }
+            break;
+
+        case repoCategory:
+            if((event->mask & IN_ISDIR) == false)
+            {
+                // metadata.xml and friends, not a package folder
+                break;
+            }
+
+            pendingPackages.insert(QString("%1/%2").arg(watchPoint.category, name));
+            if(newFolder)
+            {
+                addWatch(repoPackage, QString("%1/%2").arg(watchPoint.path, name), watchPoint.category, name);
+            }
+            break;
+
+        case repoPackage:
+            if(name.endsWith(".ebuild"))
+            {
+                pendingPackages.insert(QString("%1/%2").arg(watchPoint.category, watchPoint.package));
+            }
+            break;
+
+        case configFolder:
+            // changed config files are picked up by comparing configSignature()
+            if(newFolder && name.startsWith("package."))
+            {
+                addWatch(configFolder, QString("%1/%2").arg(watchPoint.path, name));
+            }
+            break;
+    }
+}
+
+QString K9Watcher::packageName(QString packageFolder)
+{
+    QRegularExpressionMatch match = packageFolderRE.match(packageFolder);
+    if(match.hasMatch())
+    {
+        return match.captured(1);
+    }
+    return QString();
+}
+
+void K9Watcher::applyChanges()
+{
+    // config files can change at any time (including the repos' profiles during a sync), so every batch starts fresh
+    ImportVDB importer;
+    importer.jobs = jobs;
+    importer.loadConfig();
+    const QString signature = importer.configSignature();
+
+    int rowsChanged = 0;
+    if(pendingReload || pendingPackages.count() > maxReloadAppPackages)
+    {
+        // also picks up config changes
+        importer.reloadDatabase();
+        rowsChanged = importer.rowsChanged;
+    }
+    else if(signature != configSignature || pendingPackages.isEmpty() == false)
+    {
+        if(signature != configSignature)
+        {
+            output << "Portage config changed, recomputing masks" << Qt::endl;
+            importer.remaskDatabase();
+            rowsChanged = importer.rowsChanged;
+        }
+
+        if(pendingPackages.isEmpty() == false)
+        {
+            output << "Reloading " << QStringList(pendingPackages.values()).join(' ') << Qt::endl;
+            importer.reloadApp(pendingPackages.values());
+            rowsChanged += importer.rowsChanged;
+        }
+    }
+    else
+    {
+        return;
+    }
+
+    configSignature = signature;
+    pendingPackages.clear();
+    pendingReload = false;
+
+    if(rowsChanged > 0 && pid != -1)
+    {
+        kill(pid, SIGHUP);
+    }
+}
@@ -0,0 +1,84 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9WATCHER_H
+#define K9WATCHER_H
+
+#include <QObject>
+#include <QHash>
+#include <QSet>
+#include <QString>
+#include <QTimer>
+
+class QSocketNotifier;
+class ImportVDB;
+struct inotify_event;
+
+// Keeps the database current by watching /var/db/pkg, the repo trees and
+// /etc/portage with inotify, re-importing only the packages that changed.
+class K9Watcher : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit K9Watcher(QObject *parent = nullptr);
+    ~K9Watcher();
+
+    int jobs; // passed along to ImportVDB::jobs
+    qint64 pid; // GUI process to send SIGHUP to when rows changed, -1 for none
+
+    bool start(void);
+
+private slots:
+    void readEvents(void);
+    void applyChanges(void);
+
+private:
+    enum WatchType
+    {
+        installedRoot,      // /var/db/pkg
+        installedCategory,  // /var/db/pkg/<category>
+        metaCacheRoot,      // <repo>/metadata/md5-cache
+        metaCacheCategory,  // <repo>/metadata/md5-cache/<category>
+        repoRoot,           // <repo>, for repos without an md5-cache
+        repoCategory,       // <repo>/<category>
+        repoPackage,        // <repo>/<category>/<package>
+        configFolder        // /etc/portage and its package.* folders
+    };
+
+    struct WatchPoint
+    {
+        WatchType type;
+        QString path;
+        QString category;
+        QString package;
+    };
+
+    int inotifyFd;
+    QSocketNotifier* notifier;
+    QTimer debounce;
+    QHash<int, WatchPoint> watches; // keyed by inotify watch descriptor
+    QSet<QString> pendingPackages; // "category/package" waiting for the debounce timer
+    bool pendingReload; // something changed that reloadApp() can't handle, like a new category
+    QString configSignature; // ImportVDB::configSignature() as of the last import
+
+    void addWatch(WatchType type, QString path, QString category = QString(), QString package = QString());
+    void watchRepo(QString repoFolder);
+    void handleEvent(const struct inotify_event* event);
+    QString packageName(QString packageFolder);
+};
+
+#endif // K9WATCHER_H
@@ -19,10 +19,15 @@
 #include "k9portage.h"
 #include "datastorage.h"
 #include "importvdb.h"
+#include "k9watcher.h"
+#include "k9stats.h"
 
 #include <signal.h>
 #include <QCoreApplication>
+#include <QFile>
 #include <QProcessEnvironment>
+#include <QTextStream>
+#include <QThread>
 
 int main(int argc, char *argv[])
 {
@@ -50,8 +55,16 @@ int main(int argc, char *argv[])
     ds->openDatabase();
 
     bool emerged = false;
+    bool hook = false;
     bool synced = false;
     bool reload = false;
+    bool full = false;
+    bool shadow = false;
+    bool watch = false;
+    bool remask = false;
+    bool stats = false;
+    QFile humanOutput; // where output goes under -stats, closing (and so flushing) it on the way out
+    int jobs = 1;
     qint64 pid = -1;
     QStringList appList;
 
@@ -77,6 +90,12 @@ int main(int argc, char *argv[])
             break;
         }
 
+        if(qstrcmp(argv[i], "-hook") == 0)
+        {
+            hook = true;
+            continue;
+        }
+
         if(qstrcmp(argv[i], "-progress") == 0)
         {
             showProgress = true;
@@ -89,6 +108,60 @@ int main(int argc, char *argv[])
             continue;
         }
 
+        if(qstrcmp(argv[i], "-full") == 0)
+        {
+            full = true;
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-watch") == 0)
+        {
+            watch = true;
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-root") == 0)
+        {
+            i++;
+            if(i < argc)
+            {
+                portage->setRoot(argv[i]);
+            }
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-remask") == 0)
+        {
+            remask = true;
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-stats") == 0)
+        {
+            stats = true;
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-shadow") == 0)
+        {
+            shadow = true;
+            continue;
+        }
+
+        if(qstrcmp(argv[i], "-jobs") == 0)
+        {
+            i++;
+            if(i < argc)
+            {
+                jobs = atoi(argv[i]);
+                if(jobs <= 0)
+                {
+                    jobs = QThread::idealThreadCount();
+                }
+            }
+            continue;
+        }
+
         if(qstrcmp(argv[i], "-pid") == 0)
         {
             i++;
@@ -100,6 +173,44 @@ int main(int argc, char *argv[])
         }
     }
 
+    if(stats)
+    {
+        // stdout carries nothing but the JSON report, so it can be piped straight into a parser
+        humanOutput.open(stderr, QIODevice::WriteOnly);
+        output.setDevice(&humanOutput);
+    }
+
+    if(watch)
+    {
+        output << APP_NAME << " v" << APP_VERSION << Qt::endl;
+        K9Watcher watcher;
+        watcher.jobs = jobs;
+        watcher.pid = pid;
+        if(watcher.start() == false)
+        {
+            return 1;
+        }
+        return a.exec();
+    }
+
+    if(stats && (remask || synced || reload || emerged || hook))
+    {
+        rescan = new ImportVDB();
+        rescan->stats = new K9Stats(portage->vdbFolder, portage->repos);
+    }
+
+    if(remask && synced == false)
+    {
+        if(rescan == nullptr)
+        {
+            rescan = new ImportVDB();
+        }
+        output << APP_NAME << " v" << APP_VERSION << Qt::endl;
+        rescan->jobs = jobs;
+        rescan->loadConfig();
+        rescan->remaskDatabase();
+    }
+
     if(synced)
     {
         if(rescan == nullptr)
@@ -109,14 +220,33 @@ int main(int argc, char *argv[])
 
         output << APP_NAME << " v" << APP_VERSION << Qt::endl;
         rescan->abort = false;
+        rescan->jobs = jobs;
+        rescan->fullReload = full;
+        rescan->shadow = shadow;
         rescan->loadConfig();
         rescan->reloadDatabase();
     }
     else
     {
+        if(hook)
+        {
+            // post-emerge hook: everything emerge.log says was merged or unmerged since the last run
+            if(rescan == nullptr)
+            {
+                rescan = new ImportVDB();
+            }
+            appList.append(rescan->emergeLogApps());
+            emerged = appList.isEmpty() == false;
+        }
+
         if(emerged)
         {
-            portage->emergedApp(appList);
+            if(rescan == nullptr)
+            {
+                rescan = new ImportVDB();
+            }
+            rescan->jobs = jobs;
+            rescan->emergedApps(appList);
         }
 
         if(reload)
@@ -131,6 +261,12 @@ int main(int argc, char *argv[])
         }
     }
 
+    if(rescan && rescan->stats)
+    {
+        QTextStream json(stdout);
+        json << rescan->stats->toJson(rescan->rowsChanged, rescan->jobs) << Qt::flush;
+    }
+
     if(pid != -1)
     {
         kill(pid, SIGHUP);
@@ -0,0 +1,106 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "vdbrecord.h"
+
+#include <QFile>
+
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+VdbRecord::VdbRecord()
+{
+    dirFd = -1;
+    buffer.resize(4096);
+}
+
+VdbRecord::~VdbRecord()
+{
+    close();
+}
+
+bool VdbRecord::open(int categoryFd, const QString& packageFolder)
+{
+    close();
+    dirFd = ::openat(categoryFd, QFile::encodeName(packageFolder).constData(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    return dirFd != -1;
+}
+
+void VdbRecord::close()
+{
+    if(dirFd != -1)
+    {
+        ::close(dirFd);
+        dirFd = -1;
+    }
+}
+
+// Returns false when the file doesn't exist (portage doesn't write empty values), otherwise the trimmed contents.
+bool VdbRecord::read(const char* fileName, QString& value)
+{
+    if(dirFd == -1)
+    {
+        return false;
+    }
+
+    int fd = ::openat(dirFd, fileName, O_RDONLY | O_CLOEXEC);
+    if(fd == -1)
+    {
+        return false;
+    }
+
+    int length = 0;
+    ssize_t count;
+    for(;;)
+    {
+        if(length == buffer.size())
+        {
+            buffer.resize(buffer.size() * 2);
+        }
+
+        count = ::read(fd, buffer.data() + length, buffer.size() - length);
+        if(count > 0)
+        {
+            length += count;
+        }
+        else if(count == 0 || errno != EINTR)
+        {
+            break;
+        }
+    }
+    ::close(fd);
+
+    if(count < 0)
+    {
+        return false;
+    }
+
+    value = QString::fromUtf8(buffer.constData(), length).trimmed();
+    return true;
+}
+
+// The folder's mtime in milliseconds, same as QFileInfo::lastModified() would give.
+qint64 VdbRecord::modified() const
+{
+    struct stat sb;
+    if(dirFd == -1 || fstat(dirFd, &sb) != 0)
+    {
+        return 0;
+    }
+    return static_cast<qint64>(sb.st_mtim.tv_sec) * 1000 + sb.st_mtim.tv_nsec / 1000000;
+}
@@ -0,0 +1,47 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef VDBRECORD_H
+#define VDBRECORD_H
+
+#include <QByteArray>
+#include <QString>
+
+// Reads the small metadata files portage leaves in a /var/db/pkg/category/PF folder.
+// The folder is opened once and every file is read relative to it into the same
+// buffer, instead of resolving the full path and allocating a QFile per file.
+class VdbRecord
+{
+public:
+    VdbRecord();
+    ~VdbRecord();
+
+    bool open(int categoryFd, const QString& packageFolder);
+    void close(void);
+    int fd(void) const { return dirFd; }
+
+    bool read(const char* fileName, QString& value);
+    qint64 modified(void) const;
+
+private:
+    int dirFd;
+    QByteArray buffer;
+
+    VdbRecord(const VdbRecord&) = delete;
+    VdbRecord& operator=(const VdbRecord&) = delete;
+};
+
+#endif // VDBRECORD_H
@@ -0,0 +1 @@
+../backend/datastorage.cpp
\ No newline at end of file
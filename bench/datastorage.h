@@ -0,0 +1 @@
+../backend/datastorage.h
\ No newline at end of file
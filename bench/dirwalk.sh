@@ -0,0 +1,21 @@
+#!/bin/sh
+# Compares the syscalls and wall time of walking a repo with QDir::entryList
+# against K9DirWalker. Run from the folder appswipebench was built in:
+#
+#   ./dirwalk.sh [/var/db/repos/gentoo]
+#
+# Run it twice; the first pass mostly measures the disk, not the walker.
+
+REPO=${1:-/var/db/repos/gentoo}
+BENCH=${BENCH:-./appswipebench}
+SYSCALLS=openat,getdents64,newfstatat,statx,fstat,lstat,stat,access,faccessat,faccessat2,readlink,close
+
+for MODE in -qdir -walker; do
+    echo "== $MODE"
+    "$BENCH" dirwalk $MODE -repeat 3 "$REPO"
+    if command -v strace > /dev/null; then
+        strace -f -c -e trace=$SYSCALLS "$BENCH" dirwalk $MODE "$REPO" 2>&1 > /dev/null
+    else
+        echo "strace not found, skipping syscall counts"
+    fi
+done
@@ -0,0 +1 @@
+../backend/globals.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/globals.h
\ No newline at end of file
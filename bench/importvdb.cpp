@@ -0,0 +1 @@
+../backend/importvdb.cpp
\ No newline at end of file
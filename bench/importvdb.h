@@ -0,0 +1 @@
+../backend/importvdb.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9atomaction.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9atomaction.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9atomlist.cpp
\ No newline at end of file
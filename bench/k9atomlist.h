@@ -0,0 +1 @@
+../backend/k9atomlist.h
\ No newline at end of file
@@ -0,0 +1 @@
+../transport/k9depfilter.cpp
\ No newline at end of file
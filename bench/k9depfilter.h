@@ -0,0 +1 @@
+../transport/k9depfilter.h
\ No newline at end of file
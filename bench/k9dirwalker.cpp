@@ -0,0 +1 @@
+../backend/k9dirwalker.cpp
\ No newline at end of file
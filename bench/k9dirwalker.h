@@ -0,0 +1 @@
+../backend/k9dirwalker.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9ebuild.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9ebuild.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9eclassindex.cpp
\ No newline at end of file
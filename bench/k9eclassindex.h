@@ -0,0 +1 @@
+../backend/k9eclassindex.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9metacache.cpp
\ No newline at end of file
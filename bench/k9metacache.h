@@ -0,0 +1 @@
+../backend/k9metacache.h
\ No newline at end of file
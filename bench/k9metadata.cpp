@@ -0,0 +1 @@
+../backend/k9metadata.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9metadata.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9portage.cpp
\ No newline at end of file
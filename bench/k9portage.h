@@ -0,0 +1 @@
+../backend/k9portage.h
\ No newline at end of file
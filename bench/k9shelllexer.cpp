@@ -0,0 +1 @@
+../backend/k9shelllexer.cpp
\ No newline at end of file
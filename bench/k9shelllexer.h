@@ -0,0 +1 @@
+../backend/k9shelllexer.h
\ No newline at end of file
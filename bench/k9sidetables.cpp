@@ -0,0 +1 @@
+../backend/k9sidetables.cpp
\ No newline at end of file
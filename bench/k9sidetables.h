@@ -0,0 +1 @@
+../backend/k9sidetables.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9sqlfunctions.cpp
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/k9stats.cpp
\ No newline at end of file
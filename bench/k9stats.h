@@ -0,0 +1 @@
+../backend/k9stats.h
\ No newline at end of file
@@ -0,0 +1,279 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9treegenerator.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+
+K9TreeGenerator::K9TreeGenerator()
+{
+    repos = 2;
+    categories = 20;
+    packages = 50;
+    versions = 3;
+    installedPercent = 10;
+    maskedPercent = 5;
+    contentsLines = 40;
+    arch = "amd64";
+    ebuildCount = 0;
+    installedCount = 0;
+}
+
+bool K9TreeGenerator::generate(QString root)
+{
+    this->root = root;
+    ebuildCount = 0;
+    installedCount = 0;
+    installedApps.clear();
+
+    for(int repo = 0; repo < repos; repo++)
+    {
+        if(writeRepo(repo) == false)
+        {
+            return false;
+        }
+    }
+
+    return writeInstalled() && writeProfiles();
+}
+
+bool K9TreeGenerator::writeFile(const QString& path, const QByteArray& data)
+{
+    QDir dir;
+    dir.mkpath(path.left(path.lastIndexOf('/')));
+
+    QFile file(path);
+    if(file.open(QIODevice::WriteOnly | QIODevice::Truncate) == false)
+    {
+        return false;
+    }
+    return file.write(data) == data.size();
+}
+
+QString K9TreeGenerator::categoryName(int category)
+{
+    static const char* const prefixes[] = { "app", "dev", "media", "net", "sys", "x11" };
+    return QString("%1-bench%2").arg(prefixes[category % 6]).arg(category, 2, 10, QChar('0'));
+}
+
+QString K9TreeGenerator::packageName(int package)
+{
+    return QString("pkg%1").arg(package, 3, 10, QChar('0'));
+}
+
+// 1.0, 1.1, 1.2-r1, 1.3, ... the newest version is the last one.
+QString K9TreeGenerator::versionName(int version)
+{
+    QString s = QString("1.%1").arg(version);
+    if(version % 3 == 2)
+    {
+        s.append("-r1");
+    }
+    return s;
+}
+
+QByteArray K9TreeGenerator::ebuild(const QString& category, const QString& package, int packageIndex, int version)
+{
+    QString keywords;
+    if(packageIndex % 11 == 0 || version == versions - 1)
+    {
+        // newest versions are still in testing
+        keywords = QString("~%1 ~x86").arg(arch);
+    }
+    else
+    {
+        keywords = QString("%1 ~x86").arg(arch);
+    }
+
+    QString s;
+    s.append("# Copyright 2026 Gentoo Authors\n");
+    s.append("# Distributed under the terms of the GNU General Public License v2\n\n");
+    s.append("EAPI=8\n\n");
+    s.append(QString("DESCRIPTION=\"Synthetic benchmark package %1/%2\"\n").arg(category, package));
+    s.append(QString("HOMEPAGE=\"https://example.org/%1\"\n").arg(package));
+    s.append(QString("SRC_URI=\"https://example.org/%1-${PV}.tar.xz\"\n\n").arg(package));
+    s.append("LICENSE=\"GPL-2\"\n");
+    s.append(QString("SLOT=\"%1\"\n").arg(packageIndex % 5 == 0 ? "0/1" : "0"));
+    s.append(QString("KEYWORDS=\"%1\"\n").arg(keywords));
+    s.append("IUSE=\"debug doc +nls test\"\n\n");
+    s.append("src_configure() {\n\teconf $(use_enable nls)\n}\n");
+    return s.toUtf8();
+}
+
+bool K9TreeGenerator::writeRepo(int repo)
+{
+    const QString repoName = (repo == 0) ? QString("gentoo") : QString("overlay%1").arg(repo);
+    const QString repoFolder = QString("%1/var/db/repos/%2/").arg(root, repoName);
+    if(writeFile(repoFolder + "profiles/repo_name", repoName.toUtf8() + '\n') == false)
+    {
+        return false;
+    }
+
+    QString category;
+    QString package;
+    QString pf;
+    QByteArray data;
+    QByteArray cache;
+    for(int c = 0; c < categories; c++)
+    {
+        category = categoryName(c);
+        for(int p = 0; p < packages; p++)
+        {
+            // overlays carry their own packages, so every category/package lives in exactly one repo
+            package = (repo == 0) ? packageName(p) : QString("ovl%1-%2").arg(repo).arg(packageName(p));
+            for(int v = 0; v < versions; v++)
+            {
+                pf = QString("%1-%2").arg(package, versionName(v));
+                data = ebuild(category, package, c * packages + p, v);
+                if(writeFile(QString("%1%2/%3/%4.ebuild").arg(repoFolder, category, package, pf), data) == false)
+                {
+                    return false;
+                }
+                ebuildCount++;
+
+                if(repo != 0)
+                {
+                    continue;
+                }
+
+                // same keys (and order) egencache writes
+                cache.clear();
+                foreach(const QByteArray& line, data.split('\n'))
+                {
+                    if(line.startsWith("DESCRIPTION=") || line.startsWith("HOMEPAGE=") || line.startsWith("IUSE=") ||
+                       line.startsWith("KEYWORDS=") || line.startsWith("LICENSE=") || line.startsWith("SLOT="))
+                    {
+                        QByteArray value = line.mid(line.indexOf('=') + 1);
+                        value.replace("\"", "");
+                        cache.append(line.left(line.indexOf('=') + 1) + value + '\n');
+                    }
+                }
+                cache.prepend("DEFINED_PHASES=configure\nEAPI=8\n");
+                cache.append("_md5_=" + QCryptographicHash::hash(data, QCryptographicHash::Md5).toHex() + '\n');
+                if(writeFile(QString("%1metadata/md5-cache/%2/%3").arg(repoFolder, category, pf), cache) == false)
+                {
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+bool K9TreeGenerator::writeInstalled()
+{
+    QString category;
+    QString package;
+    QString version;
+    QString folder;
+    QByteArray data;
+    QByteArray contents;
+    int packageIndex;
+    for(int c = 0; c < categories; c++)
+    {
+        category = categoryName(c);
+        for(int p = 0; p < packages; p++)
+        {
+            packageIndex = c * packages + p;
+            if(packageIndex % 100 >= installedPercent)
+            {
+                continue;
+            }
+
+            // every fifth one was installed from a version the repo has since dropped
+            package = packageName(p);
+            version = (packageIndex % 5 == 0) ? QString("0.9") : versionName(versions - 1);
+            folder = QString("%1/var/db/pkg/%2/%3-%4/").arg(root, category, package, version);
+            data = ebuild(category, package, packageIndex, versions - 1);
+
+            contents.clear();
+            contents.append(QString("dir /usr/share/%1\n").arg(package).toUtf8());
+            for(int i = 0; i < contentsLines; i++)
+            {
+                contents.append(QString("obj /usr/share/%1/file%2 %3 1767225600\n").arg(package).arg(i)
+                                .arg(QString::fromLatin1(QCryptographicHash::hash(QByteArray::number(packageIndex * 1000 + i), QCryptographicHash::Md5).toHex())).toUtf8());
+            }
+
+            if(writeFile(folder + "repository", "gentoo\n") == false ||
+               writeFile(folder + "DESCRIPTION", QString("Synthetic benchmark package %1/%2\n").arg(category, package).toUtf8()) == false ||
+               writeFile(folder + "HOMEPAGE", QString("https://example.org/%1\n").arg(package).toUtf8()) == false ||
+               writeFile(folder + "KEYWORDS", QString("~%1 ~x86\n").arg(arch).toUtf8()) == false ||
+               writeFile(folder + "IUSE", "debug doc +nls test\n") == false ||
+               writeFile(folder + "SLOT", packageIndex % 5 == 0 ? "0/1\n" : "0\n") == false ||
+               writeFile(folder + "LICENSE", "GPL-2\n") == false ||
+               writeFile(folder + "SIZE", QByteArray::number(100000 + packageIndex * 37) + '\n') == false ||
+               writeFile(folder + "CONTENTS", contents) == false ||
+               writeFile(QString("%1%2-%3.ebuild").arg(folder, package, version), data) == false)
+            {
+                return false;
+            }
+
+            installedCount++;
+            installedApps.append(QString("%1/%2").arg(category, package));
+        }
+    }
+    return true;
+}
+
+bool K9TreeGenerator::writeProfiles()
+{
+    const QString profiles = root + "/var/db/repos/gentoo/profiles/";
+    QByteArray masks;
+    QByteArray unmasks;
+    QByteArray acceptKeywords;
+    QString atom;
+    int packageIndex;
+    for(int c = 0; c < categories; c++)
+    {
+        for(int p = 0; p < packages; p++)
+        {
+            packageIndex = c * packages + p;
+            atom = QString("%1/%2").arg(categoryName(c), packageName(p));
+            if(packageIndex % 100 >= 100 - maskedPercent)
+            {
+                masks.append(QString("# Masked for benchmarking\n%1%2\n\n").arg(packageIndex % 2 ? ">=" : "", packageIndex % 2 ? atom + "-1.1" : atom).toUtf8());
+                if(packageIndex % 10 == 0)
+                {
+                    unmasks.append(atom.toUtf8() + '\n');
+                }
+            }
+
+            if(packageIndex % 11 == 0 && packageIndex % 3 == 0)
+            {
+                acceptKeywords.append(QString("%1 ~%2\n").arg(atom, arch).toUtf8());
+            }
+        }
+    }
+
+    const QString portageConfig = root + "/etc/portage/";
+    if(writeFile(profiles + "package.mask", "# repo wide masks\n") == false ||
+       writeFile(profiles + "base/make.defaults", QString("ARCH=\"%1\"\nACCEPT_KEYWORDS=\"%1\"\n").arg(arch).toUtf8()) == false ||
+       writeFile(profiles + "base/package.mask", masks) == false ||
+       writeFile(profiles + "default/parent", "../base\n") == false ||
+       writeFile(profiles + "default/make.defaults", "USE=\"bench\"\n") == false ||
+       writeFile(profiles + "default/package.unmask", unmasks) == false ||
+       writeFile(portageConfig + "make.conf", "COMMON_FLAGS=\"-O2 -pipe\"\nUSE=\"${USE} nls\"\n") == false ||
+       writeFile(portageConfig + "package.accept_keywords/bench", acceptKeywords) == false ||
+       writeFile(portageConfig + "package.mask", "") == false)
+    {
+        return false;
+    }
+
+    QFile::remove(portageConfig + "make.profile");
+    return QFile::link(profiles + "default", portageConfig + "make.profile");
+}
@@ -0,0 +1,60 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9TREEGENERATOR_H
+#define K9TREEGENERATOR_H
+
+#include <QString>
+#include <QStringList>
+
+// Writes a deterministic fake Gentoo system under a root folder: repos (the first one
+// with a metadata/md5-cache, the rest plain overlays), a /var/db/pkg with CONTENTS,
+// a profile stack and /etc/portage with package.mask and package.accept_keywords.
+// The same options always produce the same tree, so timings can be compared run to run.
+class K9TreeGenerator
+{
+public:
+    K9TreeGenerator();
+
+    int repos; // repo 0 is "gentoo" with an md5-cache, the others are overlays without one
+    int categories; // per repo
+    int packages; // per category
+    int versions; // ebuilds per package
+    int installedPercent; // of packages that get their newest version installed
+    int maskedPercent; // of packages listed in package.mask
+    int contentsLines; // files listed in each installed package's CONTENTS
+    QString arch;
+
+    bool generate(QString root);
+
+    int ebuildCount;
+    int installedCount;
+    QStringList installedApps; // "category/package" of everything installed
+
+private:
+    QString root;
+
+    bool writeFile(const QString& path, const QByteArray& data);
+    QString categoryName(int category);
+    QString packageName(int package);
+    QString versionName(int version);
+    QByteArray ebuild(const QString& category, const QString& package, int packageIndex, int version);
+    bool writeRepo(int repo);
+    bool writeInstalled(void);
+    bool writeProfiles(void);
+};
+
+#endif // K9TREEGENERATOR_H
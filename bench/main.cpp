@@ -0,0 +1,1282 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9atom.h"
+#include "k9atomlist.h"
+#include "k9depfilter.h"
+#include "k9dirwalker.h"
+#include "k9ebuild.h"
+#include "k9metacache.h"
+#include "k9treegenerator.h"
+#include "k9portage.h"
+#include "importvdb.h"
+#include "datastorage.h"
+#include "globals.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QRegularExpression>
+#include <QTemporaryDir>
+#include <QTextStream>
+#include <QStringList>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QThread>
+
+#include <sys/resource.h>
+
+// Walks repo/category/package/*.ebuild the way ImportVDB::importCategory used to.
+int walkQDir(QString repoFolder)
+{
+    int ebuildCount = 0;
+    QDir repo(repoFolder);
+    QDir category;
+    QDir builds;
+    builds.setNameFilters(QStringList("*.ebuild"));
+    foreach(QString categoryName, repo.entryList(QDir::Dirs | QDir::NoDotAndDotDot))
+    {
+        category.setPath(QString("%1/%2").arg(repoFolder, categoryName));
+        foreach(QString packageName, category.entryList(QDir::AllDirs | QDir::NoDotAndDotDot))
+        {
+            builds.setPath(QString("%1/%2/%3").arg(repoFolder, categoryName, packageName));
+            ebuildCount += builds.entryList(QDir::Files).count();
+        }
+    }
+    return ebuildCount;
+}
+
+// Same walk with K9DirWalker, the way ImportVDB::importCategory does it now.
+int walkK9DirWalker(QString repoFolder)
+{
+    int ebuildCount = 0;
+    K9DirWalker repo;
+    K9DirWalker category;
+    K9DirWalker builds;
+    if(repo.open(repoFolder) == false)
+    {
+        return 0;
+    }
+
+    foreach(QString categoryName, repo.folders())
+    {
+        if(category.openAt(repo, categoryName) == false)
+        {
+            continue;
+        }
+
+        foreach(QString packageName, category.folders())
+        {
+            if(builds.openAt(category, packageName))
+            {
+                ebuildCount += builds.files(".ebuild").count();
+            }
+        }
+    }
+    return ebuildCount;
+}
+
+// Reads an md5-cache entry the way ImportVDB used to: once as QByteArray lines for the stamp,
+// then again as a QString split into a QStringList with every key going into a QHash.
+int readMetaCacheQString(const QString& fileName, QHash<QString, QString>& vars)
+{
+    QFile input(fileName);
+    if(input.open(QIODevice::ReadOnly) == false)
+    {
+        return 0;
+    }
+
+    QString stamp;
+    QByteArray eclasses;
+    QList<QByteArray> stampLines = input.readAll().split('\n');
+    input.close();
+    foreach(const QByteArray& line, stampLines)
+    {
+        if(line.startsWith("_md5_="))
+        {
+            stamp = QString::fromLatin1(line.mid(6).trimmed());
+        }
+        else if(line.startsWith("_eclasses_="))
+        {
+            eclasses = line.mid(11).trimmed();
+        }
+    }
+    if(eclasses.isEmpty() == false)
+    {
+        stamp.append(':');
+        stamp.append(QString::fromLatin1(QCryptographicHash::hash(eclasses, QCryptographicHash::Md5).toHex()));
+    }
+
+    if(input.open(QIODevice::ReadOnly) == false)
+    {
+        return 0;
+    }
+    QString s = input.readAll();
+    input.close();
+
+    int i;
+    vars.clear();
+    QStringList lines = s.split('\n');
+    const int lineCount = lines.count();
+    for(int line = 0; line < lineCount; line++)
+    {
+        s = lines.at(line).trimmed();
+        if(s.isEmpty() || s.startsWith('#'))
+        {
+            continue;
+        }
+
+        i = s.indexOf('=');
+        if(i == -1)
+        {
+            continue;
+        }
+        vars[s.left(i)] = s.mid(i + 1);
+    }
+
+    return stamp.length() + vars.value("DESCRIPTION").length() + vars.value("HOMEPAGE").length() + vars.value("SLOT").length() +
+           vars.value("KEYWORDS").length() + vars.value("IUSE").length() + vars.value("LICENSE").length();
+}
+
+// The same stamp and fields through K9MetaCache, the way ImportVDB::importEbuild() reads them now.
+int readMetaCacheBytes(const QString& fileName, K9MetaCache& metaCache)
+{
+    if(metaCache.read(fileName) == false)
+    {
+        return 0;
+    }
+
+    QString stamp = QString::fromLatin1(metaCache.data(K9Metadata::md5), metaCache.size(K9Metadata::md5));
+    if(metaCache.size(K9Metadata::eclasses))
+    {
+        stamp.append(':');
+        stamp.append(QString::fromLatin1(QCryptographicHash::hash(QByteArray::fromRawData(metaCache.data(K9Metadata::eclasses), metaCache.size(K9Metadata::eclasses)),
+                                                                  QCryptographicHash::Md5).toHex()));
+    }
+
+    return stamp.length() + metaCache.value(K9Metadata::description).length() + metaCache.value(K9Metadata::homepage).length() +
+           metaCache.value(K9Metadata::slot).length() + metaCache.value(K9Metadata::keywords).length() +
+           metaCache.value(K9Metadata::iuse).length() + metaCache.value(K9Metadata::license).length();
+}
+
+// Lists every entry in a repo's metadata/md5-cache.
+bool listMetaCache(const QString& repoFolder, QStringList& files)
+{
+    const QString cacheFolder = repoFolder + "/metadata/md5-cache/";
+    K9DirWalker root;
+    K9DirWalker category;
+    if(root.open(cacheFolder) == false)
+    {
+        return false;
+    }
+    foreach(const QString& categoryName, root.folders())
+    {
+        if(category.openAt(root, categoryName))
+        {
+            foreach(const QString& entry, category.files())
+            {
+                files.append(cacheFolder + categoryName + '/' + entry);
+            }
+        }
+    }
+    return true;
+}
+
+struct EbuildFile
+{
+    QString path;
+    QString package;
+    QString version;
+};
+
+// Lists every repo/category/package/*.ebuild along with the package name and version it's for.
+bool listEbuilds(const QString& repoFolder, QList<EbuildFile>& files)
+{
+    EbuildFile file;
+    K9DirWalker repo;
+    K9DirWalker category;
+    K9DirWalker builds;
+    if(repo.open(repoFolder) == false)
+    {
+        return false;
+    }
+    foreach(const QString& categoryName, repo.folders())
+    {
+        if(category.openAt(repo, categoryName) == false)
+        {
+            continue;
+        }
+
+        foreach(const QString& packageName, category.folders())
+        {
+            if(builds.openAt(category, packageName) == false)
+            {
+                continue;
+            }
+
+            foreach(const QString& ebuildName, builds.files(".ebuild"))
+            {
+                file.path = QString("%1/%2/%3/%4").arg(repoFolder, categoryName, packageName, ebuildName);
+                file.package = packageName;
+                file.version = ebuildName.mid(packageName.length() + 1, ebuildName.length() - (7 + packageName.length() + 1));
+                files.append(file);
+            }
+        }
+    }
+    return true;
+}
+
+// Times both md5-cache readers over every entry in a repo's metadata/md5-cache.
+int md5cache(int argc, char *argv[])
+{
+    int repeat = 3;
+    QString repoFolder = "/var/db/repos/gentoo";
+    for(int i = 2; i < argc; i++)
+    {
+        if(qstrcmp(argv[i], "-repeat") == 0 && i + 1 < argc)
+        {
+            repeat = qMax(1, atoi(argv[++i]));
+        }
+        else
+        {
+            repoFolder = argv[i];
+        }
+    }
+
+    QStringList files;
+    if(listMetaCache(repoFolder, files) == false)
+    {
+        output << "No md5-cache under " << repoFolder << Qt::endl;
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    QHash<QString, QString> vars;
+    K9MetaCache metaCache;
+    qint64 checksum;
+    for(int run = 0; run < repeat; run++)
+    {
+        checksum = 0;
+        timer.start();
+        foreach(const QString& file, files)
+        {
+            checksum += readMetaCacheQString(file, vars);
+        }
+        output << QString("QString:     %1 entries in %2 ms (%3)").arg(files.count()).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1).arg(checksum) << Qt::endl;
+
+        checksum = 0;
+        timer.start();
+        foreach(const QString& file, files)
+        {
+            checksum += readMetaCacheBytes(file, metaCache);
+        }
+        output << QString("K9MetaCache: %1 entries in %2 ms (%3)").arg(files.count()).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1).arg(checksum) << Qt::endl;
+    }
+
+    return 0;
+}
+
+const QRegularExpression stringAssignmentRE("([^=]+)\\s*=\\s*\"((\\\\\"|[^\"])*)\"");
+const QRegularExpression variableAssignmentRE("([^=]+)\\s*=\\s*([^\"]*)");
+const QRegularExpression verCutSingleRE("\\$\\((ver_cut|get_version_component_range)\\s+([0-9]+)\\)");
+const QRegularExpression verCutRangeRE("\\$\\((ver_cut|get_version_component_range)\\s+([0-9]+)-([0-9]+)\\)");
+const QRegularExpression varRefRE("\\$\\{([A-z, 0-9, _]+)\\}");
+
+// Reads an ebuild the way K9Ebuild::ebuildReader used to: every line tried against a quoted
+// and then an unquoted assignment regex, with $(ver_cut) and ${VAR} substituted one match at a time,
+// into a hash of every variable that gets cleared and refilled for each package.
+void readEbuildRegex(const QString& fileName, const QString& packageName, VersionString& version, QHash<QString, QString>& vars)
+{
+    vars.clear();
+    vars["PN"] = packageName;
+    vars["PVR"] = version.pvr;
+    vars["PV"] = version.pv();
+    vars["PR"] = version.pr();
+    vars["P"] = QString("%1-%2").arg(vars["PN"], vars["PV"]);
+    vars["PF"] = QString("%1-%2").arg(vars["PN"], version.pvr);
+
+    QFile input(fileName);
+    if(input.open(QIODevice::ReadOnly) == false)
+    {
+        return;
+    }
+    QString s = input.readAll();
+    input.close();
+
+    QString key;
+    QString value;
+    QRegularExpressionMatch match;
+    bool matchFound;
+    int i, j;
+    QStringList lines = s.split('\n');
+    const int lineCount = lines.count();
+    for(int line = 0; line < lineCount; line++)
+    {
+        s = lines.at(line).trimmed();
+        if(s.isEmpty() || s.startsWith('#'))
+        {
+            continue;
+        }
+
+        match = stringAssignmentRE.match(s);
+        if(match.hasMatch() && match.lastCapturedIndex() >= 2)
+        {
+            key = match.captured(1).toUpper();
+            value = match.captured(2).replace("\\\"", "\"");
+        }
+        else
+        {
+            match = variableAssignmentRE.match(s);
+            if(match.hasMatch() && match.lastCapturedIndex() >= 2)
+            {
+                key = match.captured(1).toUpper();
+                value = match.captured(2);
+            }
+        }
+
+        if(key.isEmpty())
+        {
+            continue;
+        }
+
+        do
+        {
+            matchFound = false;
+            match = verCutRangeRE.match(value);
+            if(match.hasMatch())
+            {
+                matchFound = true;
+                i = match.captured(2).toInt() - 1;
+                j = match.captured(3).toInt() - 1;
+                value.replace(match.capturedStart(), match.capturedLength(), QString("%1.%2").arg(version.cut(i), version.cut(j)));
+            }
+
+            match = verCutSingleRE.match(value);
+            if(match.hasMatch())
+            {
+                matchFound = true;
+                i = match.captured(2).toInt() - 1;
+                value.replace(match.capturedStart(), match.capturedLength(), version.cut(i));
+            }
+        } while(matchFound);
+
+        match = varRefRE.match(value);
+        while(match.hasMatch())
+        {
+            s = match.captured(1).toUpper();
+            if(vars.contains(s))
+            {
+                value.replace(match.capturedStart(), match.capturedLength(), vars[s]);
+            }
+            else
+            {
+                value.remove(match.capturedStart(), match.capturedLength());
+            }
+            match = varRefRE.match(value);
+        }
+
+        vars[key] = value;
+        key.clear();
+    }
+}
+
+// Times both ebuild readers over every ebuild in a repo, the fallback path for overlays
+// without an md5-cache, and lists a few of the ebuilds they read differently.
+int ebuilds(int argc, char *argv[])
+{
+    int repeat = 3;
+    QString repoFolder = "/var/db/repos/gentoo";
+    for(int i = 2; i < argc; i++)
+    {
+        if(qstrcmp(argv[i], "-repeat") == 0 && i + 1 < argc)
+        {
+            repeat = qMax(1, atoi(argv[++i]));
+        }
+        else
+        {
+            repoFolder = argv[i];
+        }
+    }
+
+    QList<EbuildFile> files;
+    if(listEbuilds(repoFolder, files) == false)
+    {
+        output << "Couldn't open " << repoFolder << Qt::endl;
+        return 1;
+    }
+
+    QElapsedTimer timer;
+    VersionString regexVersion;
+    QHash<QString, QString> regexVars;
+    K9Ebuild lexerEbuild;
+    K9Metadata::Key key;
+    qint64 checksum;
+    int i;
+    int differences = 0;
+    for(int run = 0; run < repeat; run++)
+    {
+        checksum = 0;
+        timer.start();
+        foreach(const EbuildFile& f, files)
+        {
+            regexVersion.parse(f.version);
+            readEbuildRegex(f.path, f.package, regexVersion, regexVars);
+            for(i = 0; i < K9Metadata::ebuildKeyCount; i++)
+            {
+                checksum += regexVars.value(K9Metadata::name(static_cast<K9Metadata::Key>(i))).length();
+            }
+        }
+        output << QString("regex: %1 ebuilds in %2 ms (%3)").arg(files.count()).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1).arg(checksum) << Qt::endl;
+
+        checksum = 0;
+        timer.start();
+        foreach(const EbuildFile& f, files)
+        {
+            lexerEbuild.setPackage(f.package, f.version);
+            lexerEbuild.ebuildReader(f.path);
+            for(i = 0; i < K9Metadata::ebuildKeyCount; i++)
+            {
+                checksum += lexerEbuild.metadata.value(static_cast<K9Metadata::Key>(i)).length();
+            }
+        }
+        output << QString("lexer: %1 ebuilds in %2 ms (%3)").arg(files.count()).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1).arg(checksum) << Qt::endl;
+    }
+
+    foreach(const EbuildFile& f, files)
+    {
+        regexVersion.parse(f.version);
+        readEbuildRegex(f.path, f.package, regexVersion, regexVars);
+        lexerEbuild.setPackage(f.package, f.version);
+        lexerEbuild.ebuildReader(f.path);
+        for(i = 0; i < K9Metadata::ebuildKeyCount; i++)
+        {
+            key = static_cast<K9Metadata::Key>(i);
+            const QString before = regexVars.value(K9Metadata::name(key)).simplified();
+            const QString after = lexerEbuild.metadata.value(key);
+            if(before != after)
+            {
+                if(differences < 20)
+                {
+                    output << f.path << " " << K9Metadata::name(key) << Qt::endl << "  regex: " << before << Qt::endl << "  lexer: " << after << Qt::endl;
+                }
+                differences++;
+            }
+        }
+    }
+    output << differences << " values read differently" << Qt::endl;
+
+    return 0;
+}
+
+// Reads one of the corpus files, a line per entry, skipping blank lines and # comments.
+QStringList readCorpus(const QString& fileName)
+{
+    QStringList lines;
+    QFile input(fileName);
+    if(input.open(QIODevice::ReadOnly) == false)
+    {
+        output << "Couldn't open " << fileName << Qt::endl;
+        return lines;
+    }
+
+    QString s;
+    QTextStream stream(&input);
+    while(stream.atEnd() == false)
+    {
+        s = stream.readLine().trimmed();
+        if(s.isEmpty() == false && s.startsWith('#') == false)
+        {
+            lines.append(s);
+        }
+    }
+    input.close();
+    return lines;
+}
+
+struct CorpusPackage
+{
+    QString category;
+    QString package;
+    QString slot;
+    QString subslot;
+    VersionString version;
+};
+
+// Splits a "category/package-version:slot/subslot" line from profiles/packages.txt.
+CorpusPackage corpusPackage(const QString& line)
+{
+    CorpusPackage p;
+    QString s = line.section(':', 0, 0);
+    p.slot = line.section(':', 1);
+    if(p.slot.contains('/'))
+    {
+        p.subslot = p.slot.section('/', 1);
+        p.slot = p.slot.section('/', 0, 0);
+    }
+    p.category = s.section('/', 0, 0);
+    s = s.section('/', 1);
+
+    int versionIndex = s.lastIndexOf('-');
+    if(versionIndex > 0 && versionIndex + 1 < s.length() && s.at(versionIndex + 1) == 'r')
+    {
+        versionIndex = s.lastIndexOf('-', versionIndex - 1);
+    }
+    p.package = s.left(versionIndex);
+    p.version.parse(s.mid(versionIndex + 1));
+    return p;
+}
+
+void reportMicro(QString name, qint64 operations, qint64 nsecs, qint64 checksum)
+{
+    output << QString("%1 %2 ms  %3 ns/op  (%4)")
+              .arg(name, -34).arg(nsecs / 1000000.0, 9, 'f', 1).arg(operations > 0 ? static_cast<double>(nsecs) / operations : 0.0, 9, 'f', 1).arg(checksum) << Qt::endl;
+}
+
+// Times the parsing and matching primitives the indexer and the transport spend their time in,
+// against the fixed corpus checked in under bench/corpus, so that runs on different machines
+// and before/after a change see exactly the same input. The corpus is small; every timing
+// loops over it -loops times. The numbers in parentheses are checksums, which should only
+// change when a change in behavior was intended.
+int micro(int argc, char *argv[])
+{
+    int repeat = 3;
+    int loops = 100;
+    QString corpusFolder = CORPUS_FOLDER;
+    for(int i = 2; i < argc; i++)
+    {
+        if(qstrcmp(argv[i], "-repeat") == 0 && i + 1 < argc)
+        {
+            repeat = qMax(1, atoi(argv[++i]));
+        }
+        else if(qstrcmp(argv[i], "-loops") == 0 && i + 1 < argc)
+        {
+            loops = qMax(1, atoi(argv[++i]));
+        }
+        else
+        {
+            corpusFolder = argv[i];
+        }
+    }
+
+    const QStringList versionLines = readCorpus(corpusFolder + "/profiles/versions.txt");
+    const QStringList atomLines = readCorpus(corpusFolder + "/profiles/package.mask");
+    const QStringList packageLines = readCorpus(corpusFolder + "/profiles/packages.txt");
+    const QStringList verCutLines = readCorpus(corpusFolder + "/profiles/vercut.txt");
+    QStringList metaCacheFiles;
+    QList<EbuildFile> ebuildFiles;
+    listMetaCache(corpusFolder, metaCacheFiles);
+    listEbuilds(corpusFolder, ebuildFiles);
+    if(versionLines.isEmpty() || atomLines.isEmpty() || packageLines.isEmpty() || verCutLines.isEmpty() || metaCacheFiles.isEmpty() || ebuildFiles.isEmpty())
+    {
+        output << "Incomplete corpus in " << corpusFolder << Qt::endl;
+        return 1;
+    }
+
+    QVector<VersionString> versions(versionLines.count());
+    for(int i = 0; i < versionLines.count(); i++)
+    {
+        versions[i].parse(versionLines.at(i));
+    }
+
+    QList<CorpusPackage> packages;
+    foreach(const QString& line, packageLines)
+    {
+        packages.append(corpusPackage(line));
+    }
+
+    QList<K9Atom> atoms;
+    K9AtomList atomList;
+    for(int i = 0; i < atomLines.count(); i++)
+    {
+        atoms.append(K9Atom(atomLines.at(i)));
+        atomList.appendAtom(i, atomLines.at(i));
+    }
+
+    // SLOT="$(ver_cut 1-2)" and friends, read with PV set to the corpus version
+    static const char* const verCutNames[] = { "PV" };
+    QList<QByteArray> verCutScripts;
+    QList<QByteArray> verCutVersions;
+    foreach(const QString& line, verCutLines)
+    {
+        verCutScripts.append(QString("SLOT=\"$(ver_cut %1)\"\n").arg(line.section(' ', 0, 0)).toUtf8());
+        verCutVersions.append(line.section(' ', 1).toUtf8());
+    }
+
+    // the *DEPEND lists of each md5-cache entry, split the way the transport splits them
+    QList<QList<QStringList>> dependencies;
+    K9MetaCache metaCache;
+    foreach(const QString& fileName, metaCacheFiles)
+    {
+        QHash<QString, QString> vars;
+        readMetaCacheQString(fileName, vars);
+        QList<QStringList> lists;
+        lists.append(vars.value("BDEPEND").split(' ', Qt::SkipEmptyParts));
+        lists.append(vars.value("DEPEND").split(' ', Qt::SkipEmptyParts));
+        lists.append(vars.value("RDEPEND").split(' ', Qt::SkipEmptyParts));
+        lists.append(vars.value("PDEPEND").split(' ', Qt::SkipEmptyParts));
+        dependencies.append(lists);
+    }
+
+    output << QString("%1 versions, %2 atoms (%3 globbed), %4 packages, %5 ver_cuts, %6 ebuilds, %7 md5-cache entries, %8 loops")
+              .arg(versions.count()).arg(atoms.count()).arg(atomList.globAtoms.count()).arg(packages.count())
+              .arg(verCutScripts.count()).arg(ebuildFiles.count()).arg(metaCacheFiles.count()).arg(loops) << Qt::endl;
+
+    QElapsedTimer timer;
+    VersionString version;
+    K9Ebuild ebuild;
+    K9ShellLexer lexer;
+    K9Metadata metadata;
+    QList<QStringList> lists;
+    qint64 checksum;
+    int loop;
+    int i;
+    int j;
+    for(int run = 0; run < repeat; run++)
+    {
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            VersionString::clearCache();
+            foreach(const QString& s, versionLines)
+            {
+                version.parse(s);
+                checksum += version.sortKey().size();
+            }
+        }
+        reportMicro("VersionString::parse", static_cast<qint64>(loops) * versionLines.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const QString& s, versionLines)
+            {
+                version.parse(s);
+                checksum += version.sortKey().size();
+            }
+        }
+        reportMicro("VersionString::parse (interned)", static_cast<qint64>(loops) * versionLines.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            for(i = 0; i < versions.count(); i++)
+            {
+                for(j = 0; j < versions.count(); j++)
+                {
+                    checksum += qBound(-1, VersionString::compare(versions.at(i), versions.at(j)), 1);
+                }
+            }
+        }
+        reportMicro("VersionString::compare", static_cast<qint64>(loops) * versions.count() * versions.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const QString& s, atomLines)
+            {
+                K9Atom atom(s);
+                checksum += atom.type + atom.op;
+            }
+        }
+        reportMicro("K9Atom::K9Atom", static_cast<qint64>(loops) * atomLines.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const CorpusPackage& p, packages)
+            {
+                foreach(const K9Atom& atom, atoms)
+                {
+                    if(atom.isMatch(p.slot, p.subslot, p.version))
+                    {
+                        checksum++;
+                    }
+                }
+            }
+        }
+        reportMicro("K9Atom::isMatch", static_cast<qint64>(loops) * packages.count() * atoms.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const CorpusPackage& p, packages)
+            {
+                checksum += atomList.findMatches(p.category, p.package, p.slot, p.subslot, p.version).count();
+            }
+        }
+        reportMicro("K9AtomList::findMatches", static_cast<qint64>(loops) * packages.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const EbuildFile& f, ebuildFiles)
+            {
+                ebuild.setPackage(f.package, f.version);
+                ebuild.ebuildReader(f.path);
+                for(i = 0; i < K9Metadata::ebuildKeyCount; i++)
+                {
+                    checksum += ebuild.metadata.value(static_cast<K9Metadata::Key>(i)).length();
+                }
+            }
+        }
+        reportMicro("K9Ebuild::ebuildReader", static_cast<qint64>(loops) * ebuildFiles.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const QString& fileName, metaCacheFiles)
+            {
+                checksum += readMetaCacheBytes(fileName, metaCache);
+            }
+        }
+        reportMicro("K9MetaCache::read", static_cast<qint64>(loops) * metaCacheFiles.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            for(i = 0; i < verCutScripts.count(); i++)
+            {
+                metadata.clear();
+                lexer.parse(verCutScripts.at(i), verCutNames, &verCutVersions.at(i), 1, metadata);
+                checksum += metadata.value(K9Metadata::slot).length();
+            }
+        }
+        reportMicro("K9ShellLexer ver_cut", static_cast<qint64>(loops) * verCutScripts.count(), timer.nsecsElapsed(), checksum);
+
+        checksum = 0;
+        timer.start();
+        for(loop = 0; loop < loops; loop++)
+        {
+            foreach(const QList<QStringList>& entry, dependencies)
+            {
+                // the same filtering the transport's app view does, most specific list last
+                lists = entry;
+                for(i = 1; i < lists.count(); i++)
+                {
+                    for(j = 0; j < i; j++)
+                    {
+                        K9DepFilter::removeDuplicateDeps(lists[i], lists.at(j));
+                    }
+                    checksum += lists.at(i).count();
+                }
+            }
+        }
+        reportMicro("K9DepFilter::removeDuplicateDeps", static_cast<qint64>(loops) * dependencies.count(), timer.nsecsElapsed(), checksum);
+    }
+
+    return 0;
+}
+
+void usage()
+{
+    output << "usage: appswipebench dirwalk [-qdir|-walker] [-repeat N] <repo folder>" << Qt::endl;
+    output << "       appswipebench md5cache [-repeat N] <repo folder>" << Qt::endl;
+    output << "       appswipebench ebuilds [-repeat N] <repo folder>" << Qt::endl;
+    output << "       appswipebench micro [-repeat N] [-loops N] [corpus folder]" << Qt::endl;
+    output << "       appswipebench indexer [-repos N] [-categories N] [-packages N] [-versions N]" << Qt::endl;
+    output << "                             [-installed PERCENT] [-masked PERCENT] [-jobs N] [-keep] [root folder]" << Qt::endl;
+}
+
+// Peak resident set size of the whole run so far, in MB.
+double peakRss()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss / 1024.0;
+}
+
+qint64 packageRows()
+{
+    QSqlQuery query(ds->database());
+    if(query.exec("select count(*) from PACKAGE") && query.first())
+    {
+        return query.value(0).toLongLong();
+    }
+    return 0;
+}
+
+void report(QString phase, qint64 nsecs, qint64 rows)
+{
+    const double ms = nsecs / 1000000.0;
+    output << QString("%1 %2 ms  %3 rows  %4 rows/s  peak RSS %5 MB")
+              .arg(phase, -28).arg(ms, 10, 'f', 1).arg(rows, 8).arg(ms > 0 ? rows * 1000.0 / ms : 0.0, 10, 'f', 0).arg(peakRss(), 7, 'f', 1) << Qt::endl;
+}
+
+const QString wideSearchSql = QStringLiteral(R"EOF(
+select c.CATEGORY, p.PACKAGE, p.VERSION, p.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, p.KEYWORDS, p.SLOT
+from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+where p.PACKAGE like ? or p.DESCRIPTION like ? or c.CATEGORY=?
+)EOF");
+
+const QString narrowSearchSql = QStringLiteral(R"EOF(
+select c.CATEGORY, p.PACKAGE, p.VERSION, d.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, k.KEYWORDS, p.SLOT
+from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID
+left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID
+where p.PACKAGE like ? or d.DESCRIPTION like ? or c.CATEGORY=?
+)EOF");
+
+// Times the browser's search on a copy of the catalog, returning the rows found per run.
+qint64 searchCatalog(QString fileName, QString sql, QString term, int repeat, qint64& nsecs)
+{
+    qint64 rows = 0;
+    {
+        QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", "LayoutBench");
+        db.setDatabaseName(fileName);
+        db.open();
+
+        QSqlQuery query(db);
+        query.setForwardOnly(true);
+        query.prepare(sql);
+        QElapsedTimer timer;
+        timer.start();
+        for(int i = 0; i < repeat; i++)
+        {
+            query.bindValue(0, "%" + term + "%");
+            query.bindValue(1, "%" + term + "%");
+            query.bindValue(2, term);
+            query.exec();
+            rows = 0;
+            while(query.next())
+            {
+                rows++;
+            }
+        }
+        nsecs = timer.nsecsElapsed() / repeat;
+        query.finish();
+        db.close();
+    }
+    QSqlDatabase::removeDatabase("LayoutBench");
+    return rows;
+}
+
+// Copies the catalog twice: once with the metadata strings inline in PACKAGE, the way they
+// were stored before the side tables, and once as it is now. Compares file size and search time.
+void compareCatalogLayouts(QString folder, QString term)
+{
+    const QString wideFile = folder + "/wide.db";
+    const QString narrowFile = folder + "/narrow.db";
+    QFile::remove(wideFile);
+    QFile::remove(narrowFile);
+
+    QSqlQuery query(ds->database());
+    query.prepare("attach database ? as WIDE");
+    query.bindValue(0, wideFile);
+    query.exec();
+    query.prepare("attach database ? as NARROW");
+    query.bindValue(0, narrowFile);
+    query.exec();
+
+    const QStringList sideTables = {"DESCRIPTION", "HOMEPAGE", "KEYWORDS", "IUSE", "LICENSE"};
+    QString table;
+    bool ok = query.exec("create table WIDE.CATEGORY as select * from CATEGORY") &&
+              query.exec("create table WIDE.PACKAGE as select p.PACKAGEID, p.CATEGORYID, p.REPOID, p.PACKAGE, d.DESCRIPTION, h.HOMEPAGE, p.VERSION, "
+                         "p.V1, p.V2, p.V3, p.V4, p.V5, p.V6, p.V7, p.V8, p.V9, p.V10, p.SLOT, l.LICENSE, p.INSTALLED, p.FROMBINARY, p.OBSOLETED, p.MASKED, "
+                         "p.DOWNLOADSIZE, k.KEYWORDS, i.IUSE, p.PUBLISHED, p.STATUS, p.SUBSLOT, p.VERSIONKEY from PACKAGE p "
+                         "left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID "
+                         "left join HOMEPAGE h on h.HOMEPAGEID = p.HOMEPAGEID "
+                         "left join LICENSE l on l.LICENSEID = p.LICENSEID "
+                         "left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID "
+                         "left join IUSE i on i.IUSEID = p.IUSEID") &&
+              query.exec("create table NARROW.CATEGORY as select * from CATEGORY") &&
+              query.exec("create table NARROW.PACKAGE as select * from PACKAGE");
+    foreach(table, sideTables)
+    {
+        ok = ok && query.exec(QString("create table NARROW.%1 as select * from %1").arg(table)) &&
+             query.exec(QString("create unique index NARROW.%1_TEXT on %1 (%1)").arg(table));
+    }
+    query.exec("detach database WIDE");
+    query.exec("detach database NARROW");
+    if(ok == false)
+    {
+        output << "Couldn't copy the catalog: " << query.lastError().text() << Qt::endl;
+        return;
+    }
+
+    const qint64 wideSize = QFileInfo(wideFile).size();
+    const qint64 narrowSize = QFileInfo(narrowFile).size();
+    output << QString("%1 %2 KB inline  %3 KB side tables  (%4%)")
+              .arg(QString("catalog size"), -28).arg(wideSize / 1024).arg(narrowSize / 1024)
+              .arg(wideSize > 0 ? narrowSize * 100 / wideSize : 0) << Qt::endl;
+
+    const int repeat = 20;
+    qint64 nsecs;
+    qint64 rows = searchCatalog(wideFile, wideSearchSql, term, repeat, nsecs);
+    report("search (inline strings)", nsecs, rows);
+    rows = searchCatalog(narrowFile, narrowSearchSql, term, repeat, nsecs);
+    report("search (side tables)", nsecs, rows);
+
+    QFile::remove(wideFile);
+    QFile::remove(narrowFile);
+}
+
+// Updates INSTALLED the way K9Portage::emergedApp used to after an emerge: one select
+// per app, then one update or delete per version row, each stat()ing its own vdb folder.
+void emergedAppPerQuery(QStringList appList)
+{
+    QSqlDatabase db;
+    if(QSqlDatabase::contains("GuiThread") == false)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE", "GuiThread");
+    }
+    else
+    {
+        db = QSqlDatabase::database("GuiThread");
+        if(db.isValid())
+        {
+            db.close();
+        }
+    }
+
+    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
+    db.open();
+
+    QSqlQuery query(db);
+    QSqlQuery updatePackage(db);
+    QSqlQuery deletePackage(db);
+    query.prepare(QStringLiteral(R"EOF(
+select PACKAGEID, VERSION, INSTALLED, OBSOLETED, DOWNLOADSIZE
+from PACKAGE
+where CATEGORYID=(select CATEGORYID from CATEGORY where CATEGORY=?) and PACKAGE=?
+)EOF"));
+    updatePackage.prepare(QStringLiteral("update PACKAGE set INSTALLED=?, DOWNLOADSIZE=? where PACKAGEID=?"));
+    deletePackage.prepare(QStringLiteral("delete from PACKAGE where PACKAGEID=?"));
+
+    QStringList x;
+    QString category;
+    QString packageName;
+    QFile input;
+    QString data;
+    bool ok;
+
+    qint64 packageId;
+    qint64 installed;
+    QString version;
+    QString installedFilePath;
+    int downloadSize;
+    QFileInfo fi;
+    bool obsoleted;
+
+    const int appCount = appList.count();
+    for(int i = 0; i < appCount; i++)
+    {
+        x = appList.at(i).split('/');
+        category = x.first();
+        packageName = x.last();
+        query.bindValue(0, category);
+        query.bindValue(1, packageName);
+
+        if(query.exec() == false || query.first() == false)
+        {
+            return;
+        }
+
+        do
+        {
+            packageId = query.value(0).toInt();
+            version = query.value(1).toString();
+            installed = query.value(2).toInt();
+            obsoleted = query.value(3).toInt() != 0;
+            downloadSize = query.value(4).toInt();
+
+            if(downloadSize == -1)
+            {
+                data = QString("%1%2/%3-%4/SIZE").arg(portage->vdbFolder, category, packageName, version);
+                input.setFileName(data);
+                if(input.open(QIODevice::ReadOnly))
+                {
+                    data = input.readAll();
+                    input.close();
+                    data = data.trimmed();
+                    downloadSize = data.toInt(&ok);
+                    if(ok == false)
+                    {
+                        downloadSize = -1;
+                    }
+                }
+            }
+
+            installedFilePath = QString("%1%2/%3-%4").arg(portage->vdbFolder, category, packageName, version);
+            fi.setFile(installedFilePath);
+            if(fi.exists())
+            {
+                if(installed == 0)
+                {
+                    installed = fi.birthTime().toSecsSinceEpoch();
+                    updatePackage.bindValue(0, installed);
+                    updatePackage.bindValue(1, downloadSize);
+                    updatePackage.bindValue(2, packageId);
+                    if(updatePackage.exec() == false)
+                    {
+                        output << QString("update installed %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
+                    }
+                }
+            }
+            else
+            {
+                if(installed)
+                {
+                    if(obsoleted)
+                    {
+                        deletePackage.bindValue(0, packageId);
+                        if(deletePackage.exec() == false)
+                        {
+                            output << QString("delete uninstalled obsolete %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
+                        }
+                    }
+                    else
+                    {
+                        installed = 0;
+                        updatePackage.bindValue(0, installed);
+                        updatePackage.bindValue(1, downloadSize);
+                        updatePackage.bindValue(2, packageId);
+                        if(updatePackage.exec() == false)
+                        {
+                            output << QString("update uninstalled %1/%2-%3 failed").arg(category, packageName, version) << Qt::endl;
+                        }
+                    }
+                }
+            }
+        } while(query.next());
+    }
+}
+
+// Generates a fake tree under a temporary root and times the backend's import paths against it.
+int indexer(int argc, char *argv[])
+{
+    K9TreeGenerator generator;
+    QString rootFolder;
+    bool keep = false;
+    int jobs = 1;
+    for(int i = 2; i < argc; i++)
+    {
+        if(qstrcmp(argv[i], "-repos") == 0 && i + 1 < argc)
+        {
+            generator.repos = qMax(1, atoi(argv[++i]));
+        }
+        else if(qstrcmp(argv[i], "-categories") == 0 && i + 1 < argc)
+        {
+            generator.categories = qMax(1, atoi(argv[++i]));
+        }
+        else if(qstrcmp(argv[i], "-packages") == 0 && i + 1 < argc)
+        {
+            generator.packages = qMax(1, atoi(argv[++i]));
+        }
+        else if(qstrcmp(argv[i], "-versions") == 0 && i + 1 < argc)
+        {
+            generator.versions = qMax(1, atoi(argv[++i]));
+        }
+        else if(qstrcmp(argv[i], "-installed") == 0 && i + 1 < argc)
+        {
+            generator.installedPercent = qBound(0, atoi(argv[++i]), 100);
+        }
+        else if(qstrcmp(argv[i], "-masked") == 0 && i + 1 < argc)
+        {
+            generator.maskedPercent = qBound(0, atoi(argv[++i]), 100);
+        }
+        else if(qstrcmp(argv[i], "-jobs") == 0 && i + 1 < argc)
+        {
+            jobs = atoi(argv[++i]);
+            if(jobs <= 0)
+            {
+                jobs = QThread::idealThreadCount();
+            }
+        }
+        else if(qstrcmp(argv[i], "-keep") == 0)
+        {
+            keep = true;
+        }
+        else
+        {
+            rootFolder = argv[i];
+        }
+    }
+
+    QTemporaryDir temporaryRoot;
+    if(rootFolder.isEmpty())
+    {
+        if(temporaryRoot.isValid() == false)
+        {
+            output << "Couldn't create a temporary folder." << Qt::endl;
+            return 1;
+        }
+        temporaryRoot.setAutoRemove(keep == false);
+        rootFolder = temporaryRoot.path();
+    }
+
+    portage = new K9Portage();
+    generator.arch = portage->arch;
+
+    QElapsedTimer timer;
+    timer.start();
+    if(generator.generate(rootFolder) == false)
+    {
+        output << "Couldn't write the fake tree under " << rootFolder << Qt::endl;
+        return 1;
+    }
+    report("generate tree", timer.nsecsElapsed(), generator.ebuildCount + generator.installedCount);
+    output << QString("%1 ebuilds, %2 installed, under %3").arg(generator.ebuildCount).arg(generator.installedCount).arg(rootFolder) << Qt::endl;
+
+    portage->setRoot(rootFolder);
+    ds = new DataStorage();
+    ds->storageFolder = rootFolder + "/storage/";
+    ds->openDatabase();
+
+    ImportVDB importer;
+    importer.jobs = jobs;
+    importer.shadow = false;
+
+    timer.start();
+    importer.loadConfig();
+    report("loadConfig (parse)", timer.nsecsElapsed(), importer.atoms.count());
+
+    timer.start();
+    importer.reloadDatabase();
+    report("reloadDatabase (full)", timer.nsecsElapsed(), packageRows());
+
+    ImportVDB cached;
+    cached.jobs = jobs;
+    timer.start();
+    cached.loadConfig();
+    report("loadConfig (cached)", timer.nsecsElapsed(), cached.atoms.count());
+
+    timer.start();
+    cached.reloadDatabase();
+    report("reloadDatabase (unchanged)", timer.nsecsElapsed(), packageRows());
+
+    cached.fullReload = true;
+    timer.start();
+    cached.reloadDatabase();
+    report("reloadDatabase (-full)", timer.nsecsElapsed(), packageRows());
+    cached.fullReload = false;
+
+    const QStringList apps = generator.installedApps;
+    timer.start();
+    cached.reloadApp(apps);
+    report("reloadApp (installed)", timer.nsecsElapsed(), static_cast<qint64>(apps.count()) * generator.versions);
+
+    timer.start();
+    emergedAppPerQuery(apps);
+    report("emergedApp (per query)", timer.nsecsElapsed(), apps.count());
+
+    timer.start();
+    cached.emergedApps(apps);
+    report("emergedApps (batched)", timer.nsecsElapsed(), apps.count());
+
+    if(apps.isEmpty() == false)
+    {
+        compareCatalogLayouts(rootFolder, apps.first().section('/', 1));
+    }
+
+    if(keep)
+    {
+        output << "Kept " << rootFolder << Qt::endl;
+    }
+    return 0;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication::setOrganizationName("K9spud LLC");
+    QCoreApplication::setApplicationName("appswipebench");
+    QCoreApplication a(argc, argv);
+
+    if(argc >= 2 && qstrcmp(argv[1], "indexer") == 0)
+    {
+        return indexer(argc, argv);
+    }
+
+    if(argc >= 2 && qstrcmp(argv[1], "md5cache") == 0)
+    {
+        return md5cache(argc, argv);
+    }
+
+    if(argc >= 2 && qstrcmp(argv[1], "ebuilds") == 0)
+    {
+        return ebuilds(argc, argv);
+    }
+
+    if(argc >= 2 && qstrcmp(argv[1], "micro") == 0)
+    {
+        return micro(argc, argv);
+    }
+
+    if(argc < 2 || qstrcmp(argv[1], "dirwalk") != 0)
+    {
+        usage();
+        return 1;
+    }
+
+    bool useQDir = true;
+    bool useWalker = true;
+    int repeat = 1;
+    QString repoFolder = "/var/db/repos/gentoo";
+    for(int i = 2; i < argc; i++)
+    {
+        if(qstrcmp(argv[i], "-qdir") == 0)
+        {
+            useWalker = false;
+        }
+        else if(qstrcmp(argv[i], "-walker") == 0)
+        {
+            useQDir = false;
+        }
+        else if(qstrcmp(argv[i], "-repeat") == 0 && i + 1 < argc)
+        {
+            repeat = qMax(1, atoi(argv[++i]));
+        }
+        else
+        {
+            repoFolder = argv[i];
+        }
+    }
+
+    QElapsedTimer timer;
+    int ebuildCount;
+    for(int run = 0; run < repeat; run++)
+    {
+        if(useQDir)
+        {
+            timer.start();
+            ebuildCount = walkQDir(repoFolder);
+            output << QString("QDir:        %1 ebuilds in %2 ms").arg(ebuildCount).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1) << Qt::endl;
+        }
+
+        if(useWalker)
+        {
+            timer.start();
+            ebuildCount = walkK9DirWalker(repoFolder);
+            output << QString("K9DirWalker: %1 ebuilds in %2 ms").arg(ebuildCount).arg(timer.nsecsElapsed() / 1000000.0, 0, 'f', 1) << Qt::endl;
+        }
+    }
+
+    return 0;
+}
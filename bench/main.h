@@ -0,0 +1 @@
+../backend/main.h
\ No newline at end of file
@@ -0,0 +1 @@
+../backend/vdbrecord.cpp
\ No newline at end of file
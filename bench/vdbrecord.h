@@ -0,0 +1 @@
+../backend/vdbrecord.h
\ No newline at end of file
@@ -0,0 +1 @@
+../versionstring.cpp
\ No newline at end of file
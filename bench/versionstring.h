@@ -0,0 +1 @@
+../versionstring.h
\ No newline at end of file
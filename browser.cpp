@@ -163,7 +163,7 @@ BrowserWindow* Browser::createWindow(int windowId)
 
 void Browser::discardWindow(int windowId)
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery query(db);
 
     db.transaction();
@@ -210,7 +210,7 @@ void Browser::closeAll()
 
 QVector<Browser::WindowHash> Browser::inactiveWindows()
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery qry(db);
     QVector<WindowHash> windows;
 
@@ -365,7 +365,7 @@ void Browser::loadWindows(QSqlQuery& windowQuery, QSqlQuery& tabQuery)
 
 void Browser::restoreWindows()
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery tabQuery(db);
     QSqlQuery windowQuery(db);
 
@@ -375,7 +375,7 @@ void Browser::restoreWindows()
 
 void Browser::loadWindow(int windowId)
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery tabQuery(db);
     QSqlQuery windowQuery(db);
 
@@ -392,7 +392,7 @@ int Browser::createWindowId()
 {
     int windowId = 0;
 
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery qry(db);
     if(qry.exec("select max(WINDOWID) from WINDOW"))
     {
@@ -504,7 +504,7 @@ void Browser::saveWindow(BrowserWindow* window, bool active, QSqlQuery& qwindow,
 
 void Browser::saveWindow(BrowserWindow* window, bool active)
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery query(db);
     QSqlQuery qwindow(db);
 
@@ -519,7 +519,7 @@ void Browser::saveWindow(BrowserWindow* window, bool active)
 
 void Browser::saveAllWindows()
 {
-    QSqlDatabase db = QSqlDatabase::database(ds->connectionName);
+    QSqlDatabase db = ds->database();
     QSqlQuery query(db);
     QSqlQuery qwindow(db);
 
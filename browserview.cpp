@@ -17,6 +17,7 @@
 #include "browserview.h"
 #include "compositeview.h"
 #include "datastorage.h"
+#include "k9sqlfunctions.h"
 #include "k9portage.h"
 #include "globals.h"
 #include "k9shell.h"
@@ -352,6 +353,11 @@ void BrowserView::setUrl(const QUrl& url)
         currentUrl = url.toString();
         viewAppFiles(url);
     }
+    else if(scheme == "eclass")
+    {
+        currentUrl = url.toString();
+        viewEclass(url.path(QUrl::FullyDecoded));
+    }
     else if(scheme == "new")
     {
         currentUrl = url.toString();
@@ -597,6 +603,131 @@ void BrowserView::viewUseFlag(const QUrl& url)
     }
 }
 
+// Lists every package version that inherits the eclass, directly or through another eclass,
+// from the index the backend builds out of md5-cache _eclasses_. Installed packages come
+// first, since those are the ones an eclass change will have rebuilt.
+void BrowserView::viewEclass(QString eclass)
+{
+    QSqlDatabase db;
+    if(QSqlDatabase::contains("GuiThread") == false)
+    {
+        db = QSqlDatabase::addDatabase("QSQLITE", "GuiThread");
+    }
+    else
+    {
+        db = QSqlDatabase::database("GuiThread");
+        if(db.isValid())
+        {
+            db.close();
+        }
+    }
+
+    db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
+    db.open();
+    K9SqlFunctions::install(db);
+
+    composite->setIcon(":/img/search.svg");
+
+    QSqlQuery query(db);
+    query.prepare(R"EOF(
+select c.CATEGORY, p.PACKAGE, p.VERSION, p.INSTALLED, p.OBSOLETED, e.DIRECT
+from ECLASS x
+inner join PACKAGEECLASS e on e.ECLASSID = x.ECLASSID
+inner join PACKAGE p on p.PACKAGEID = e.PACKAGEID
+inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+where x.ECLASS = ?
+order by c.CATEGORY, p.PACKAGE, p.VERSIONKEY desc
+)EOF");
+    query.bindValue(0, eclass);
+    if(query.exec() == false || query.first() == false)
+    {
+        error(QString("No packages inherit the \"%1\" eclass.").arg(eclass.toHtmlEscaped()));
+        return;
+    }
+
+    QString installedApps;
+    QString availableApps;
+    QString versions;
+    QString version;
+    QString app;
+    QString nextApp;
+    bool installed;
+    bool anyInstalled = false;
+    int appCount = 0;
+    int versionCount = 0;
+    int installedCount = 0;
+    bool exitLoop = false;
+
+    app = QString("%1/%2").arg(query.value(0).toString(), query.value(1).toString());
+    while(exitLoop == false)
+    {
+        versionCount++;
+        installed = (query.value(3).toLongLong() != 0);
+        version = query.value(2).toString();
+        if(installed)
+        {
+            installedCount++;
+            anyInstalled = true;
+            version = QString("<B>%1</B>").arg(version);
+        }
+        if(query.value(5).isNull() == false && query.value(5).toInt() == 0)
+        {
+            version = QString("<I>%1</I>").arg(version);
+        }
+        if(versions.isEmpty() == false)
+        {
+            versions.append(", ");
+        }
+        versions.append(version);
+
+        if(query.next() == false)
+        {
+            exitLoop = true;
+        }
+        else
+        {
+            nextApp = QString("%1/%2").arg(query.value(0).toString(), query.value(1).toString());
+        }
+
+        if(exitLoop || nextApp != app)
+        {
+            appCount++;
+            if(anyInstalled)
+            {
+                installedApps.append(QString("<P><A HREF=\"app:%1\">%1</A><BR>%2</P>\n").arg(app, versions));
+            }
+            else
+            {
+                availableApps.append(QString("<P><A HREF=\"app:%1\">%1</A><BR>%2</P>\n").arg(app, versions));
+            }
+            app = nextApp;
+            versions.clear();
+            anyInstalled = false;
+        }
+    }
+
+    QString result = QString(R"EOF(
+<HTML>
+<HEAD>
+<TITLE>"%1" eclass</TITLE>
+</HEAD>
+<BODY>
+<P><B>"%1" eclass</B> is inherited by %2 versions of %3 packages, %4 of them installed.
+Installed versions are in <B>bold</B>, versions that only inherit it through another eclass in <I>italics</I>.</P>
+)EOF").arg(eclass.toHtmlEscaped()).arg(versionCount).arg(appCount).arg(installedCount);
+    result.append(installedApps);
+    result.append(availableApps);
+    result.append("<P>&nbsp;</P>\n");
+    result.append("</BODY>\n</HTML>\n");
+
+    QString oldTitle = documentTitle();
+    setHtml(result);
+    if(documentTitle() != oldTitle)
+    {
+        emit titleChanged(documentTitle());
+    }
+}
+
 void BrowserView::quseProcessFinished(int exitCode, QProcess::ExitStatus exitStatus)
 {
     Q_UNUSED(exitCode);
@@ -888,6 +1019,7 @@ void BrowserView::viewUpdates(QString action, QString filter)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
 
     QString result = "<HTML>\n";
     result.append(QString("<HEAD><TITLE>Update Packages</TITLE></HEAD>\n<BODY>"));
@@ -945,24 +1077,15 @@ void BrowserView::viewUpdates(QString action, QString filter)
 
     QString sql =
         QString(R"EOF(
-            select c.CATEGORY, p.PACKAGE, p2.VERSION, p.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, p.KEYWORDS, p.SLOT, p.VERSION
+            select c.CATEGORY, p.PACKAGE, p2.VERSION, d.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, k.KEYWORDS, p.SLOT, p.VERSION
             from PACKAGE p
             inner join CATEGORY c on c.CATEGORYID=p.CATEGORYID
+            left join DESCRIPTION d on d.DESCRIPTIONID=p.DESCRIPTIONID
+            left join KEYWORDS k on k.KEYWORDSID=p.KEYWORDSID
             inner join PACKAGE p2 on p2.PACKAGE=p.PACKAGE and p2.CATEGORYID=p.CATEGORYID and
                 p2.SLOT is p.SLOT and p2.PACKAGEID != p.PACKAGEID and p2.INSTALLED=0 and p2.MASKED=0 and
                 p2.VERSION != '9999' and p2.VERSION != '99999' and p2.VERSION != '999999' and p2.VERSION != '9999999' and p2.VERSION != '99999999' and p2.VERSION != '999999999' and
-            (
-                (p2.V1 > p.V1) or
-                (p2.V1 is p.V1 and p2.V2 > p.V2) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 > p.V3) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 > p.V4) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 > p.V5) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 > p.V6) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 > p.V7) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 > p.V8) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 is p.V8 and p2.V9 > p.V9) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 is p.V8 and p2.V9 is p.V9 and p2.V10 > p.V10)
-            )
+                p2.VERSIONKEY > p.VERSIONKEY
             where p.INSTALLED != 0 and
             (
                 p2.MASKED = 0 or
@@ -971,7 +1094,7 @@ void BrowserView::viewUpdates(QString action, QString filter)
                 (p.STATUS=2 and p2.STATUS=2)
             ) %1 %2
             group by c.CATEGORY, p.PACKAGE, p.SLOT
-            order by c.CATEGORY, p.PACKAGE, p.MASKED, p2.V1 desc, p2.V2 desc, p2.V3 desc, p2.V4 desc, p2.V5 desc, p2.V6 desc, p2.V7 desc, p2.V8 desc, p2.V9 desc, p2.V10 desc
+            order by c.CATEGORY, p.PACKAGE, p.MASKED, p2.VERSIONKEY desc
             limit 10000
             )EOF").arg(sqlFilter);
 
@@ -1070,6 +1193,7 @@ void BrowserView::searchApps(QString search, bool feelingLucky)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
 
     QString result = "<HTML>\n";
     result.append(QString("<HEAD><TITLE>%1 search</TITLE></HEAD>\n<BODY>").arg(search));
@@ -1078,14 +1202,14 @@ void BrowserView::searchApps(QString search, bool feelingLucky)
     QString glob = search.replace('*', "%");
     if(search.contains('/'))
     {
-        query.prepare("select c.CATEGORY, p.PACKAGE, p.VERSION, p.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, p.KEYWORDS, p.SLOT from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID where c.CATEGORY like ? and p.PACKAGE like ? order by c.CATEGORY, p.PACKAGE, p.MASKED, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6 desc, p.V7 desc, p.V8 desc, p.V9 desc, p.V10 desc limit 10000");
+        query.prepare("select c.CATEGORY, p.PACKAGE, p.VERSION, d.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, k.KEYWORDS, p.SLOT from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID where c.CATEGORY like ? and p.PACKAGE like ? order by c.CATEGORY, p.PACKAGE, p.MASKED, p.VERSIONKEY desc limit 10000");
         QStringList x = glob.split('/');
         query.bindValue(0, "%" + x.first() + "%");
         query.bindValue(1, "%" + x.last() + "%");
     }
     else
     {
-        query.prepare("select c.CATEGORY, p.PACKAGE, p.VERSION, p.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, p.KEYWORDS, p.SLOT from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID where p.PACKAGE like ? or p.DESCRIPTION like ? or c.CATEGORY=? order by c.CATEGORY, p.PACKAGE, p.MASKED, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6 desc, p.V7 desc, p.V8 desc, p.V9 desc, p.V10 desc limit 10000");
+        query.prepare("select c.CATEGORY, p.PACKAGE, p.VERSION, d.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, k.KEYWORDS, p.SLOT from PACKAGE p inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID where p.PACKAGE like ? or d.DESCRIPTION like ? or c.CATEGORY=? order by c.CATEGORY, p.PACKAGE, p.MASKED, p.VERSIONKEY desc limit 10000");
         query.bindValue(0, "%" + glob + "%");
         query.bindValue(1, "%" + glob + "%");
         query.bindValue(2, glob);
@@ -1113,17 +1237,20 @@ void BrowserView::whatsNew(QString search, bool feelingLucky)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
 
     QString result = "<HTML>\n";
     result.append(QString("<HEAD><TITLE>What's New</TITLE></HEAD>\n<BODY>"));
 
     QSqlQuery query(db);
     query.prepare(R"EOF(
-select c.CATEGORY, p.PACKAGE, p.VERSION, p.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, p.KEYWORDS
+select c.CATEGORY, p.PACKAGE, p.VERSION, d.DESCRIPTION, p.INSTALLED, p.MASKED, p.OBSOLETED, k.KEYWORDS
 from PACKAGE p
 inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID
+left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID
 where (p.PACKAGE, p.CATEGORYID) in (select p2.PACKAGE, p2.CATEGORYID from PACKAGE p2 where p2.PUBLISHED > ?)
-order by c.CATEGORY, p.PACKAGE, p.MASKED, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6 desc, p.V7 desc, p.V8 desc, p.V9 desc, p.V10 desc
+order by c.CATEGORY, p.PACKAGE, p.MASKED, p.VERSIONKEY desc
 limit 10000;
 )EOF");
     QDateTime dt = QDateTime::currentDateTime();
@@ -85,6 +85,7 @@ public slots:
     void viewApp(const QUrl& url);
     void viewProcess(QString cmd, QStringList options);
     void viewUseFlag(const QUrl& url);
+    void viewEclass(QString eclass);
     void viewAppFiles(const QUrl& url);
     void viewUpdates(QString action, QString filter);
     void reloadApp(const QUrl& url);
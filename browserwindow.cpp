@@ -264,7 +264,7 @@ BrowserWindow::BrowserWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::
         {
             cmd.append(" --ask");
         }
-        cmd.append(QString("\nexport RET_CODE=$?\n%1 -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
+        cmd.append(QString("\nexport RET_CODE=$?\n%1 -jobs 0 -shadow -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
 
         exec(cmd, "Sync Repos");
     });
@@ -306,7 +306,7 @@ BrowserWindow::BrowserWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::
         {
             cmd.append(" --ask");
         }
-        cmd.append(QString("\nexport RET_CODE=$?\n%1 -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
+        cmd.append(QString("\nexport RET_CODE=$?\n%1 -jobs 0 -shadow -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
 
         exec(cmd, "Update System");
     });
@@ -320,7 +320,7 @@ BrowserWindow::BrowserWindow(QWidget* parent) : QMainWindow(parent), ui(new Ui::
         {
             cmd.append(" --ask");
         }
-        cmd.append(QString("\nexport RET_CODE=$?\n%1 -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
+        cmd.append(QString("\nexport RET_CODE=$?\n%1 -jobs 0 -shadow -synced -pid %2").arg(shell->backend).arg(qApp->applicationPid()));
         exec(cmd, "Update World");
     });
     menu->addAction(action);
@@ -818,7 +818,7 @@ void BrowserWindow::reloadDatabase()
     connect(view->browser(), &BrowserView::loadFinished, this, &BrowserWindow::reloadDatabaseComplete);
     connect(view->browser(), &BrowserView::loadProgress, ui->searchProgress, &QProgressBar::setValue);
     QStringList options;
-    options << "-progress" << "-synced" << "-pid" << QString::number(qApp->applicationPid());
+    options << "-progress" << "-jobs" << "0" << "-shadow" << "-synced" << "-full" << "-pid" << QString::number(qApp->applicationPid());
 
     view->browser()->viewProcess(shell->backend, options);
 }
@@ -1,4 +1,4 @@
-// Copyright (c) 2021-2025, K9spud LLC.
+// Copyright (c) 2021-2026, K9spud LLC.
 //
 // This program is free software; you can redistribute it and/or
 // modify it under the terms of the GNU General Public License
@@ -20,15 +20,22 @@
 #include <QStandardPaths>
 #include <QMessageBox>
 #include <QSqlQuery>
+#include <QSqlError>
 #include <QUuid>
 #include <QApplication>
 #include <QElapsedTimer>
 #include <QThread>
 #include <QSettings>
+#include <QVector>
+#include <QPair>
 
 #include "datastorage.h"
+#include "k9sqlfunctions.h"
+#include "versionstring.h"
 #include "main.h"
 
+#include <sys/stat.h>
+
 DataStorage* ds = nullptr;
 int DataStorage::connectionCount = 0;
 
@@ -45,6 +52,7 @@ DataStorage::DataStorage()
     defaultStoragePath.append("/" APP_FOLDER "/");
     storageFolder = settings.value("storagePath", defaultStoragePath).toString();
     emptyDatabase = true;
+    databaseFileId = -1;
 }
 
 DataStorage::~DataStorage()
@@ -145,6 +153,7 @@ QString DataStorage::openDatabase()
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
         db.setDatabaseName(storageFolder + databaseFileName);
         db.open();
+        K9SqlFunctions::install(db);
         db.transaction();
         if(runSqlScript(db, ":/sql/createSettings.sql") == false)
         {
@@ -165,6 +174,7 @@ QString DataStorage::openDatabase()
         QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
         db.setDatabaseName(storageFolder + databaseFileName);
         db.open();
+        K9SqlFunctions::install(db);
         emptyDatabase = false;
 
         int schemaVersion;
@@ -183,20 +193,48 @@ QString DataStorage::openDatabase()
             schemaVersion = query.value(0).toInt();
         }
 
-        if(schemaVersion < 5)
+        if(schemaVersion < 12)
         {
             upgradeDatabase(query, db, schemaVersion);
         }
     }
 
+    databaseFileId = currentFileId();
     return connectionName;
 }
 
+// The backend's -shadow reload renames a rebuilt database over ours. A connection that stays
+// open would keep reading (and writing into) the old file, so reopen it when that happens.
+QSqlDatabase DataStorage::database()
+{
+    QSqlDatabase db = QSqlDatabase::database(connectionName);
+    const qint64 fileId = currentFileId();
+    if(fileId != databaseFileId)
+    {
+        db.close();
+        db.open();
+        K9SqlFunctions::install(db);
+        databaseFileId = fileId;
+    }
+    return db;
+}
+
+qint64 DataStorage::currentFileId()
+{
+    struct stat sb;
+    if(stat(QFile::encodeName(storageFolder + databaseFileName).constData(), &sb) != 0)
+    {
+        return -1;
+    }
+    return static_cast<qint64>(sb.st_ino);
+}
+
 void DataStorage::createDatabase(QString connectionName, QString databaseFileName, QString scriptFileName)
 {
     QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", connectionName);
     db.setDatabaseName(databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
 
     db.transaction();
     if(runSqlScript(db, scriptFileName) == false)
@@ -219,6 +257,26 @@ bool DataStorage::upgradeDatabase(QSqlQuery& query, QSqlDatabase& db, int schema
 
     db.transaction();
 
+    if(schemaVersion < 7)
+    {
+        if(query.exec("alter table REPO add column HEADCOMMIT text") == false)
+        {
+            qDebug() << "Couldn't add column REPO.HEADCOMMIT upgrading from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+    }
+
+    if(schemaVersion < 6)
+    {
+        if(query.exec("alter table META add column CONFIGHASH text") == false)
+        {
+            qDebug() << "Couldn't add column META.CONFIGHASH upgrading from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+    }
+
     if(schemaVersion < 5)
     {
         if(query.exec("alter table PACKAGE add column V7 int") == false)
@@ -280,8 +338,9 @@ bool DataStorage::upgradeDatabase(QSqlQuery& query, QSqlDatabase& db, int schema
         }
     }
 
-    if(schemaVersion < 3)
+    if(schemaVersion < 5)
     {
+        // pre-5 rows are thrown away and reloaded anyway, nothing to carry over
         if(query.exec("drop table PACKAGE") == false)
         {
             qDebug() << "Couldn't drop PACKAGE to perform upgrade from schemaVersion:" << schemaVersion;
@@ -290,6 +349,28 @@ bool DataStorage::upgradeDatabase(QSqlQuery& query, QSqlDatabase& db, int schema
         }
         emptyDatabase = true;
     }
+    else if(schemaVersion < 9)
+    {
+        // PACKAGE's text columns move out into side tables; keep the old rows
+        // around long enough to copy them over with their PACKAGEIDs intact
+        if(query.exec("alter table PACKAGE rename to PACKAGE8") == false)
+        {
+            qDebug() << "Couldn't rename PACKAGE to perform upgrade from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+    }
+
+    if(schemaVersion >= 9 && schemaVersion < 11)
+    {
+        // has to exist before createSettings.sql indexes it
+        if(query.exec("alter table PACKAGE add column VERSIONKEY blob") == false)
+        {
+            qDebug() << "Couldn't add column PACKAGE.VERSIONKEY upgrading from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+    }
 
     if(runSqlScript(db, ":/sql/createSettings.sql") == false)
     {
@@ -298,7 +379,87 @@ bool DataStorage::upgradeDatabase(QSqlQuery& query, QSqlDatabase& db, int schema
         return false;
     }
 
-    int finalVersion = 5;
+    if(schemaVersion >= 5 && schemaVersion < 9)
+    {
+        const QStringList sideTables = {"DESCRIPTION", "HOMEPAGE", "KEYWORDS", "IUSE", "LICENSE"};
+        QString table;
+        foreach(table, sideTables)
+        {
+            if(query.exec(QString("insert into %1 (%1) select distinct %1 from PACKAGE8 where %1 is not null and %1<>''").arg(table)) == false)
+            {
+                qDebug() << "Couldn't fill" << table << "upgrading from schemaVersion:" << schemaVersion << query.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+
+        if(query.exec("insert into PACKAGE (PACKAGEID, CATEGORYID, REPOID, PACKAGE, DESCRIPTIONID, HOMEPAGEID, VERSION, "
+                      "V1, V2, V3, V4, V5, V6, V7, V8, V9, V10, SLOT, LICENSEID, INSTALLED, FROMBINARY, OBSOLETED, MASKED, "
+                      "DOWNLOADSIZE, KEYWORDSID, IUSEID, PUBLISHED, STATUS, SUBSLOT) "
+                      "select p.PACKAGEID, p.CATEGORYID, p.REPOID, p.PACKAGE, d.DESCRIPTIONID, h.HOMEPAGEID, p.VERSION, "
+                      "p.V1, p.V2, p.V3, p.V4, p.V5, p.V6, p.V7, p.V8, p.V9, p.V10, p.SLOT, l.LICENSEID, p.INSTALLED, p.FROMBINARY, p.OBSOLETED, p.MASKED, "
+                      "p.DOWNLOADSIZE, k.KEYWORDSID, i.IUSEID, p.PUBLISHED, p.STATUS, p.SUBSLOT from PACKAGE8 p "
+                      "left join DESCRIPTION d on d.DESCRIPTION = p.DESCRIPTION "
+                      "left join HOMEPAGE h on h.HOMEPAGE = p.HOMEPAGE "
+                      "left join LICENSE l on l.LICENSE = p.LICENSE "
+                      "left join KEYWORDS k on k.KEYWORDS = p.KEYWORDS "
+                      "left join IUSE i on i.IUSE = p.IUSE") == false)
+        {
+            qDebug() << "Couldn't copy PACKAGE rows upgrading from schemaVersion:" << schemaVersion << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+
+        if(query.exec("drop table PACKAGE8") == false)
+        {
+            qDebug() << "Couldn't drop PACKAGE8 upgrading from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+    }
+
+    if(schemaVersion < 12)
+    {
+        // PACKAGEECLASS starts out empty; without fingerprints the next reload reads every ebuild
+        // again, diffing the rows we have so their PACKAGEIDs survive
+        if(query.exec("delete from FINGERPRINT") == false)
+        {
+            qDebug() << "Couldn't clear FINGERPRINT upgrading from schemaVersion:" << schemaVersion;
+            db.rollback();
+            return false;
+        }
+
+        // PACKAGE.VERSIONKEY is new (or, from version 11, in the old key encoding). Work it out from
+        // VERSION now, so update checks and version ordering don't have to wait for that reload.
+        QVector<QPair<qint64, QString>> versions;
+        if(query.exec("select PACKAGEID, VERSION from PACKAGE") == false)
+        {
+            qDebug() << "Couldn't read PACKAGE versions upgrading from schemaVersion:" << schemaVersion << query.lastError().text();
+            db.rollback();
+            return false;
+        }
+        while(query.next())
+        {
+            versions.append(qMakePair(query.value(0).toLongLong(), query.value(1).toString()));
+        }
+
+        VersionString version;
+        query.prepare("update PACKAGE set VERSIONKEY=? where PACKAGEID=?");
+        for(int i = 0; i < versions.count(); i++)
+        {
+            version.parse(versions.at(i).second);
+            query.bindValue(0, version.sortKey());
+            query.bindValue(1, versions.at(i).first);
+            if(query.exec() == false)
+            {
+                qDebug() << "Couldn't fill PACKAGE.VERSIONKEY upgrading from schemaVersion:" << schemaVersion << query.lastError().text();
+                db.rollback();
+                return false;
+            }
+        }
+    }
+
+    int finalVersion = 12;
     query.prepare("update META set UUID=ifnull(UUID,?), SCHEMAVERSION=?");
     query.bindValue(0, QUuid::createUuid().toString(QUuid::WithoutBraces));
     query.bindValue(1, finalVersion);
@@ -0,0 +1 @@
+backend/k9atom.cpp
\ No newline at end of file
@@ -16,6 +16,7 @@
 
 #include "k9portage.h"
 #include "datastorage.h"
+#include "k9sqlfunctions.h"
 
 #include <QDir>
 #include <QDebug>
@@ -28,10 +29,6 @@
 
 K9Portage::K9Portage(QObject *parent) : QObject(parent)
 {
-    separator.setPattern("([^A-Za-z0-9]+)");
-    digitVersion.setPattern("([0-9]+)");
-    alphaVersion.setPattern("([A-Za-z]+)");
-
     // see https://devmanual.gentoo.org/general-concepts/dependencies/
     // See Restrictions upon Names: https://projects.gentoo.org/pms/8/pms.html#x1-150003
     //                              https://dev.gentoo.org/~ulm/pms/head/pms.html#chapter-3
@@ -130,14 +127,16 @@ void K9Portage::autoKeyword(QString app, QString op)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    K9SqlFunctions::install(db);
     QSqlQuery query(db);
     QString s = R"EOF(
-select p.KEYWORDS, p.MASKED, r.REPO, c.CATEGORY, p.PACKAGE, p.VERSION, p.SLOT, p.SUBSLOT
+select k.KEYWORDS, p.MASKED, r.REPO, c.CATEGORY, p.PACKAGE, p.VERSION, p.SLOT, p.SUBSLOT
 from PACKAGE p
 inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
 inner join REPO r on r.REPOID = p.REPOID
+left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID
 where c.CATEGORY || '/' || p.PACKAGE || '-' || p.VERSION = ?
-order by c.CATEGORY, p.PACKAGE, p.MASKED, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6 desc, p.V7 desc, p.V8 desc, p.V9 desc, p.V10 desc
+order by c.CATEGORY, p.PACKAGE, p.MASKED, p.VERSIONKEY desc
 )EOF";
 
     query.prepare(s);
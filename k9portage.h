@@ -35,10 +35,6 @@ public:
 
     QString arch;
 
-    QRegularExpression separator;
-    QRegularExpression digitVersion;
-    QRegularExpression alphaVersion;
-
     QRegularExpression dependKeywordsBasicRE;
     QRegularExpression dependKeywordsVersionRE;
     QRegularExpression dependKeywordsSlotRE;
@@ -0,0 +1 @@
+backend/k9sqlfunctions.h
\ No newline at end of file
@@ -1,4 +1,4 @@
--- Copyright (c) 2021-2023, K9spud LLC.
+-- Copyright (c) 2021-2026, K9spud LLC.
 --
 -- This program is free software; you can redistribute it and/or
 -- modify it under the terms of the GNU General Public License
@@ -16,9 +16,10 @@
 
 create table if not exists META (
     SCHEMAVERSION integer,
-    UUID text
+    UUID text,
+    CONFIGHASH text
 );
-insert into META(SCHEMAVERSION) SELECT 5 WHERE NOT EXISTS(SELECT 0 FROM META);
+insert into META(SCHEMAVERSION) SELECT 12 WHERE NOT EXISTS(SELECT 0 FROM META);
 
 create table if not exists WINDOW (
     WINDOWID integer primary key,
@@ -51,16 +52,52 @@ create table if not exists CATEGORY (
 create table if not exists REPO (
     REPOID integer primary key autoincrement,
     REPO text,
-    LOCATION text
+    LOCATION text,
+    HEADCOMMIT text
 );
 
+create table if not exists DESCRIPTION (
+    DESCRIPTIONID integer primary key autoincrement,
+    DESCRIPTION text
+);
+
+create unique index if not exists DESCRIPTION_TEXT on DESCRIPTION (DESCRIPTION);
+
+create table if not exists HOMEPAGE (
+    HOMEPAGEID integer primary key autoincrement,
+    HOMEPAGE text
+);
+
+create unique index if not exists HOMEPAGE_TEXT on HOMEPAGE (HOMEPAGE);
+
+create table if not exists KEYWORDS (
+    KEYWORDSID integer primary key autoincrement,
+    KEYWORDS text
+);
+
+create unique index if not exists KEYWORDS_TEXT on KEYWORDS (KEYWORDS);
+
+create table if not exists IUSE (
+    IUSEID integer primary key autoincrement,
+    IUSE text
+);
+
+create unique index if not exists IUSE_TEXT on IUSE (IUSE);
+
+create table if not exists LICENSE (
+    LICENSEID integer primary key autoincrement,
+    LICENSE text
+);
+
+create unique index if not exists LICENSE_TEXT on LICENSE (LICENSE);
+
 create table if not exists PACKAGE (
     PACKAGEID integer primary key autoincrement,
     CATEGORYID integer,
     REPOID integer,
     PACKAGE text,
-    DESCRIPTION text,
-    HOMEPAGE text,
+    DESCRIPTIONID integer,
+    HOMEPAGEID integer,
     VERSION text,
     V1 int,
     V2 int,
@@ -73,19 +110,73 @@ create table if not exists PACKAGE (
     V9 int,
     V10 int,
     SLOT text,
-    LICENSE text,
+    LICENSEID integer,
     INSTALLED integer,
     FROMBINARY integer,
     OBSOLETED integer,
     MASKED integer,
     DOWNLOADSIZE integer,
-    KEYWORDS text,
-    IUSE text,
+    KEYWORDSID integer,
+    IUSEID integer,
     PUBLISHED integer,
     STATUS integer,
-    SUBSLOT text
+    SUBSLOT text,
+    VERSIONKEY blob
 );
 
+create index if not exists PACKAGE_VERSIONKEY on PACKAGE (CATEGORYID, PACKAGE, SLOT, VERSIONKEY);
+
+create table if not exists ECLASS (
+    ECLASSID integer primary key autoincrement,
+    ECLASS text
+);
+
+create unique index if not exists ECLASS_TEXT on ECLASS (ECLASS);
+
+create table if not exists PACKAGEECLASS (
+    PACKAGEID integer,
+    ECLASSID integer,
+    DIRECT integer
+);
+
+create index if not exists PACKAGEECLASS_ECLASS on PACKAGEECLASS (ECLASSID);
+create index if not exists PACKAGEECLASS_PACKAGE on PACKAGEECLASS (PACKAGEID);
+
+create table if not exists FINGERPRINT (
+    PATH text primary key,
+    CATEGORYID integer,
+    PACKAGE text,
+    PACKAGEID integer,
+    STAMP text
+);
+
+create index if not exists FINGERPRINT_PACKAGE on FINGERPRINT (CATEGORYID, PACKAGE);
+
+create table if not exists EBUILDCACHE (
+    PATH text primary key,
+    STAMP text,
+    DESCRIPTION text,
+    HOMEPAGE text,
+    SLOT text,
+    KEYWORDS text,
+    IUSE text,
+    LICENSE text
+);
+
+-- FINGERPRINT: one row per ebuild (or /var/db/pkg folder) seen by the last reload.
+--              PACKAGEID is null when the ebuild has no row of its own (it's installed).
+--              STAMP is the md5-cache _md5_ value, or mtime:size for repos without a cache.
+-- EBUILDCACHE: variables parsed out of ebuilds in repos without an md5-cache, so unchanged ebuilds skip the parse.
+--              STAMP is the ebuild's mtime:size when it was parsed.
+-- REPO.HEADCOMMIT: git commit the repo was last indexed at, empty when it isn't a git checkout
+-- DESCRIPTION, HOMEPAGE, KEYWORDS, IUSE, LICENSE: each distinct value once; the versions of a package nearly always share them.
+--              PACKAGE refers to them by id, null when the ebuild left the variable empty.
+-- PACKAGEECLASS: one row for every eclass a PACKAGE row inherits, from md5-cache _eclasses_ (or the VDB's INHERITED
+--              for installed versions without an md5-cache entry). DIRECT = 1 when the ebuild's own inherit line names it,
+--              null when that isn't known.
+-- PACKAGE.VERSIONKEY: VersionString::sortKey() of VERSION; ordering by it puts versions in PMS order
+-- META.CONFIGHASH: md5 of the config files that were read when the PACKAGE.MASKED values were computed
+
 -- PACKAGE.STATUS: 0 = unknown, 1 = testing, 2 = stable
 -- PACKAGE.MASKED:  bit 0: 1 = masked 0 = not masked
 --                  bit 1: 1 = keyword masked (testing), 0 = keyworded
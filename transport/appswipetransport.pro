@@ -7,10 +7,24 @@ CONFIG += c++11
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
+# K9SqlFunctions hands SQL functions to the QSQLITE driver's sqlite3 handles through our own
+# libsqlite3, which is only safe when the driver links that same library (Qt's -system-sqlite).
+# Run qmake with CONFIG+=bundled_sqlite to build without them against a bundled-SQLite driver.
+bundled_sqlite {
+    DEFINES += K9_BUNDLED_SQLITE
+} else {
+    !system(ldd $$[QT_INSTALL_PLUGINS]/sqldrivers/libqsqlite.so | grep -q libsqlite3): \
+        error("Qt's QSQLITE driver isn't linked against the system libsqlite3. Use a Qt built with -system-sqlite, or run qmake with CONFIG+=bundled_sqlite.")
+    LIBS += -lsqlite3
+}
+
 SOURCES += \
         datastorage.cpp \
         globals.cpp \
+        k9atom.cpp \
+        k9depfilter.cpp \
         k9portage.cpp \
+        k9sqlfunctions.cpp \
         main.cpp \
         versionstring.cpp
 
@@ -22,7 +36,10 @@ else: unix:!android: target.path = /opt/$${TARGET}/bin
 HEADERS += \
     datastorage.h \
     globals.h \
+    k9atom.h \
+    k9depfilter.h \
     k9portage.h \
+    k9sqlfunctions.h \
     main.h \
     versionstring.h
 
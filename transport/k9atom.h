@@ -0,0 +1 @@
+../backend/k9atom.h
\ No newline at end of file
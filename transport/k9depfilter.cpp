@@ -0,0 +1,147 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#include "k9depfilter.h"
+
+int K9DepFilter::depMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex)
+{
+    if(targetIndex < 0 || sourceIndex < 0)
+    {
+        return -1;
+    }
+
+    int parens = 0;
+    int i = targetIndex;
+    int j = sourceIndex;
+    bool foundEnd = false;
+    QString s;
+    while(i < target.count() && j < source.count() && foundEnd == false)
+    {
+        s = target.at(i).trimmed();
+        if(s == "(")
+        {
+            parens++;
+        }
+        else if(s == ")")
+        {
+            parens--;
+            if(parens == 0)
+            {
+                foundEnd = true;
+            }
+        }
+
+        if(j >= source.count())
+        {
+            return -1;
+        }
+
+        if(s != source.at(j))
+        {
+            return -1;
+        }
+
+        i++;
+        j++;
+    }
+
+    targetIndex = i;
+    return i;
+}
+
+void K9DepFilter::skipNode(const QStringList& nodes, int& index)
+{
+    int parens = 0;
+    QString s;
+    bool foundEnd = false;
+    while(index < nodes.count() && foundEnd == false)
+    {
+        s = nodes.at(index).trimmed();
+        if(s == "(")
+        {
+            parens++;
+        }
+        else if(s == ")")
+        {
+            parens--;
+            if(parens == 0)
+            {
+                foundEnd = true;
+            }
+        }
+        index++;
+    }
+}
+
+int K9DepFilter::outerDepMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex)
+{
+    QString s = target.at(targetIndex);
+    int j = source.indexOf(s, sourceIndex);
+    if(j < 0)
+    {
+        skipNode(target, targetIndex);
+        return -1;
+    }
+
+    int result = depMatch(target, targetIndex, source, j);
+    if(result >= 0)
+    {
+        return result;
+    }
+
+    skipNode(source, j);
+    return outerDepMatch(target, targetIndex, source, j);
+}
+
+void K9DepFilter::removeDuplicateDeps(QStringList& target, const QStringList& source)
+{
+    int i = 0;
+    QString s;
+    int j;
+    int endMatch;
+    int removeStart;
+    int sourceSearch;
+    while(i < target.count())
+    {
+        s = target.at(i).trimmed();
+        if(s.endsWith('?') || s == "||")
+        {
+            removeStart = i;
+            sourceSearch = 0;
+            j = source.indexOf(s, sourceSearch);
+            endMatch = outerDepMatch(target, i, source, j);
+            if(endMatch >= 0)
+            {
+                j = removeStart;
+                i = removeStart;
+                while(i < target.count() && j < endMatch)
+                {
+                    target.removeAt(i);
+                    j++;
+                }
+            }
+
+            continue;
+        }
+        else if(source.contains(s))
+        {
+            // don't show target dependencies that are already listed in the source dependencies list
+            target.removeAt(i);
+            continue;
+        }
+        i++;
+    }
+}
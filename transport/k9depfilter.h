@@ -0,0 +1,33 @@
+// Copyright (c) 2026, K9spud LLC.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+
+#ifndef K9DEPFILTER_H
+#define K9DEPFILTER_H
+
+#include <QStringList>
+
+// Drops the entries of one *DEPEND list that an earlier list already shows, so the app view
+// doesn't print the same dependency (or the same "use? ( ... )" / "|| ( ... )" group) twice.
+class K9DepFilter
+{
+public:
+    static void removeDuplicateDeps(QStringList& target, const QStringList& source);
+    static int outerDepMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex);
+    static void skipNode(const QStringList& nodes, int& index);
+    static int depMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex);
+};
+
+#endif // K9DEPFILTER_H
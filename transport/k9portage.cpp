@@ -30,10 +30,6 @@
 
 K9Portage::K9Portage(QObject *parent) : QObject(parent)
 {
-    separator.setPattern("([^A-Za-z0-9]+)");
-    digitVersion.setPattern("([0-9]+)");
-    alphaVersion.setPattern("([A-Za-z]+)");
-
     // see https://devmanual.gentoo.org/general-concepts/dependencies/
     // See Restrictions upon Names: https://projects.gentoo.org/pms/8/pms.html#x1-150003
     //                              https://dev.gentoo.org/~ulm/pms/head/pms.html#chapter-3
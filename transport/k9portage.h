@@ -46,10 +46,6 @@ public:
 
     void md5cacheReader(QString fileName);
 
-    QRegularExpression separator;
-    QRegularExpression digitVersion;
-    QRegularExpression alphaVersion;
-
     QRegularExpression dependKeywordsBasicRE;
     QRegularExpression dependKeywordsVersionRE;
     QRegularExpression dependKeywordsSlotRE;
@@ -18,6 +18,8 @@
 #include "globals.h"
 #include "k9portage.h"
 #include "datastorage.h"
+#include "k9sqlfunctions.h"
+#include "k9depfilter.h"
 
 #include <QApplication>
 #include <QProcessEnvironment>
@@ -41,15 +43,13 @@
 bool isWorld = false;
 QHash<QString, QString> iconMap;    // category type, icon resource file name
 int viewWidth = 0, viewHeight = 0;
+bool sqlFunctions = false; // atom_match() is available on GuiThread
 
 void viewApp(const QUrl& url);
 QString appVersion(QString app);
 QString appNoVersion(QString app);
-void removeDuplicateDeps(QStringList& target, const QStringList& source);
-int outerDepMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex);
-void skipNode(const QStringList& nodes, int& index);
-int depMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex);
 QString findAppIcon(bool& hasIcon, QString category, QString package, QString version);
+QString dependencyAtom(QString dependency);
 QString printDependencies(QStringList dependencies, QSqlQuery& query, bool flagMissing);
 
 int main(int argc, char *argv[])
@@ -202,16 +202,22 @@ void viewApp(const QUrl& url)
 
     db.setDatabaseName(ds->storageFolder + ds->databaseFileName);
     db.open();
+    sqlFunctions = K9SqlFunctions::install(db);
     QSqlQuery query(db);
     query.prepare(QStringLiteral(R"EOF(
 select
-    r.REPO, p.PACKAGE, p.VERSION, p.DESCRIPTION, p.INSTALLED, p.OBSOLETED, p.SLOT, p.HOMEPAGE, p.LICENSE,
-    p.KEYWORDS, p.IUSE, c.CATEGORY, p.PACKAGE, p.MASKED, p.DOWNLOADSIZE, p.PACKAGEID, p.SUBSLOT
+    r.REPO, p.PACKAGE, p.VERSION, d.DESCRIPTION, p.INSTALLED, p.OBSOLETED, p.SLOT, h.HOMEPAGE, l.LICENSE,
+    k.KEYWORDS, i.IUSE, c.CATEGORY, p.PACKAGE, p.MASKED, p.DOWNLOADSIZE, p.PACKAGEID, p.SUBSLOT
 from PACKAGE p
 inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
 inner join REPO r on r.REPOID = p.REPOID
+left join DESCRIPTION d on d.DESCRIPTIONID = p.DESCRIPTIONID
+left join HOMEPAGE h on h.HOMEPAGEID = p.HOMEPAGEID
+left join LICENSE l on l.LICENSEID = p.LICENSEID
+left join KEYWORDS k on k.KEYWORDSID = p.KEYWORDSID
+left join IUSE i on i.IUSEID = p.IUSEID
 where c.CATEGORY=? and p.PACKAGE=?
-order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6 desc, p.V7 desc, p.V8 desc, p.V9 desc, p.V10 desc
+order by p.PACKAGE, p.VERSIONKEY desc
 )EOF"));
 
     QString search = url.path(QUrl::FullyDecoded);
@@ -771,7 +777,7 @@ order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6
         if(libDepend.isEmpty() == false)
         {
             libDeps = libDepend.remove("\n").split(' ', Qt::SkipEmptyParts);
-            removeDuplicateDeps(libDeps, buildDeps);
+            K9DepFilter::removeDuplicateDeps(libDeps, buildDeps);
             if(libDeps.count())
             {
                 output << "<P><B>Dependencies on libraries, headers, etc (DEPEND)" << Qt::flush << ":</B></P><P>";
@@ -783,8 +789,8 @@ order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6
         if(installDepend.isEmpty() == false)
         {
             installDeps = installDepend.remove("\n").split(' ', Qt::SkipEmptyParts);
-            removeDuplicateDeps(installDeps, buildDeps);
-            removeDuplicateDeps(installDeps, libDeps);
+            K9DepFilter::removeDuplicateDeps(installDeps, buildDeps);
+            K9DepFilter::removeDuplicateDeps(installDeps, libDeps);
             if(installDeps.count())
             {
                 output << "<P><B>Dependencies needed during installation (IDEPEND)" << Qt::flush << ":</B></P><P>";
@@ -796,9 +802,9 @@ order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6
         if(runDepend.isEmpty() == false)
         {
             runDeps = runDepend.remove("\n").split(' ', Qt::SkipEmptyParts);
-            removeDuplicateDeps(runDeps, buildDeps);
-            removeDuplicateDeps(runDeps, libDeps);
-            removeDuplicateDeps(runDeps, installDeps);
+            K9DepFilter::removeDuplicateDeps(runDeps, buildDeps);
+            K9DepFilter::removeDuplicateDeps(runDeps, libDeps);
+            K9DepFilter::removeDuplicateDeps(runDeps, installDeps);
             if(runDeps.count())
             {
                 output << "<P><B>Dependencies needed at runtime (RDEPEND)" << Qt::flush << ":</B></P><P>";
@@ -810,10 +816,10 @@ order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6
         if(postDepend.isEmpty() == false)
         {
             postDeps = postDepend.remove("\n").split(' ', Qt::SkipEmptyParts);
-            removeDuplicateDeps(postDeps, buildDeps);
-            removeDuplicateDeps(postDeps, libDeps);
-            removeDuplicateDeps(postDeps, installDeps);
-            removeDuplicateDeps(postDeps, runDeps);
+            K9DepFilter::removeDuplicateDeps(postDeps, buildDeps);
+            K9DepFilter::removeDuplicateDeps(postDeps, libDeps);
+            K9DepFilter::removeDuplicateDeps(postDeps, installDeps);
+            K9DepFilter::removeDuplicateDeps(postDeps, runDeps);
             if(postDeps.count())
             {
                 output << "<P><B>Dependencies not strictly needed immediately (PDEPEND)" << Qt::flush << ":</B></P><P>";
@@ -829,136 +835,6 @@ order by p.PACKAGE, p.V1 desc, p.V2 desc, p.V3 desc, p.V4 desc, p.V5 desc, p.V6
     error << "isWorld " << (isWorld ? "1" : "0") << Qt::endl;
 }
 
-int depMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex)
-{
-    if(targetIndex < 0 || sourceIndex < 0)
-    {
-        return -1;
-    }
-
-    int parens = 0;
-    int i = targetIndex;
-    int j = sourceIndex;
-    bool foundEnd = false;
-    QString s;
-    while(i < target.count() && j < source.count() && foundEnd == false)
-    {
-        s = target.at(i).trimmed();
-        if(s == "(")
-        {
-            parens++;
-        }
-        else if(s == ")")
-        {
-            parens--;
-            if(parens == 0)
-            {
-                foundEnd = true;
-            }
-        }
-
-        if(j >= source.count())
-        {
-            return -1;
-        }
-
-        if(s != source.at(j))
-        {
-            return -1;
-        }
-
-        i++;
-        j++;
-    }
-
-    targetIndex = i;
-    return i;
-}
-
-void skipNode(const QStringList& nodes, int& index)
-{
-    int parens = 0;
-    QString s;
-    bool foundEnd = false;
-    while(index < nodes.count() && foundEnd == false)
-    {
-        s = nodes.at(index).trimmed();
-        if(s == "(")
-        {
-            parens++;
-        }
-        else if(s == ")")
-        {
-            parens--;
-            if(parens == 0)
-            {
-                foundEnd = true;
-            }
-        }
-        index++;
-    }
-}
-
-int outerDepMatch(QStringList& target, int& targetIndex, const QStringList& source, int sourceIndex)
-{
-    QString s = target.at(targetIndex);
-    int j = source.indexOf(s, sourceIndex);
-    if(j < 0)
-    {
-        skipNode(target, targetIndex);
-        return -1;
-    }
-
-    int result = depMatch(target, targetIndex, source, j);
-    if(result >= 0)
-    {
-        return result;
-    }
-
-    skipNode(source, j);
-    return outerDepMatch(target, targetIndex, source, j);
-}
-
-void removeDuplicateDeps(QStringList& target, const QStringList& source)
-{
-    int i = 0;
-    QString s;
-    int j;
-    int endMatch;
-    int removeStart;
-    int sourceSearch;
-    while(i < target.count())
-    {
-        s = target.at(i).trimmed();
-        if(s.endsWith('?') || s == "||")
-        {
-            removeStart = i;
-            sourceSearch = 0;
-            j = source.indexOf(s, sourceSearch);
-            endMatch = outerDepMatch(target, i, source, j);
-            if(endMatch >= 0)
-            {
-                j = removeStart;
-                i = removeStart;
-                while(i < target.count() && j < endMatch)
-                {
-                    target.removeAt(i);
-                    j++;
-                }
-            }
-
-            continue;
-        }
-        else if(source.contains(s))
-        {
-            // don't show target dependencies that are already listed in the source dependencies list
-            target.removeAt(i);
-            continue;
-        }
-        i++;
-    }
-}
-
 QString appNoVersion(QString app)
 {
     int versionIndex = app.lastIndexOf('-');
@@ -1079,60 +955,102 @@ QString findAppIcon(bool& hasIcon, QString category, QString package, QString ve
     return appicon;
 }
 
+// Turns a *DEPEND entry into an atom K9Atom understands: USE dependencies, repositories and slot
+// operators are dropped, and so is the slot of a versioned atom, which K9Atom can only parse
+// along with a repository. Blockers come back empty, since they never make a dependency missing.
+QString dependencyAtom(QString dependency)
+{
+    if(dependency.isEmpty() || dependency.startsWith('!'))
+    {
+        return QString();
+    }
+
+    int i = dependency.indexOf('[');
+    if(i != -1)
+    {
+        dependency.truncate(i);
+    }
+
+    i = dependency.indexOf("::");
+    if(i != -1)
+    {
+        dependency.truncate(i);
+    }
+
+    i = dependency.indexOf(':');
+    if(i != -1)
+    {
+        QString slot = dependency.mid(i + 1);
+        dependency.truncate(i);
+        if(slot.endsWith('='))
+        {
+            slot.chop(1);
+        }
+
+        if(slot.isEmpty() == false && slot != "*" && QString("~=<>").contains(dependency.at(0)) == false)
+        {
+            dependency.append(':');
+            dependency.append(slot);
+        }
+    }
+    return dependency;
+}
+
+const QString installedAtomSql = QStringLiteral(R"EOF(
+    select 1 from PACKAGE p
+    inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+    where c.CATEGORY = ? and p.PACKAGE = ? and p.INSTALLED != 0 and atom_match(?, c.CATEGORY, p.PACKAGE, p.VERSION, p.SLOT, p.SUBSLOT)
+    limit 1
+    )EOF");
+
+const QString installedPackageSql = QStringLiteral(R"EOF(
+    select 1 from PACKAGE p
+    inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
+    where c.CATEGORY = ? and p.PACKAGE = ? and p.INSTALLED != 0
+    limit 1
+    )EOF");
+
 QString printDependencies(QStringList dependencies, QSqlQuery& query, bool flagMissing)
 {
     QString s;
     QString category;
     QString package;
+    QString atom;
+    QStringList checkedAtoms;
     QStringList missingAtoms;
     QStringList upgradableAtoms;
     if(true || flagMissing)
     {
+        // an installed version only satisfies the dependency if it's in the atom's version range and
+        // slot; without atom_match() any installed version of the package has to do
+        query.prepare(sqlFunctions ? installedAtomSql : installedPackageSql);
         for(int i = 0; i < dependencies.count(); i++)
         {
             s = dependencies.at(i);
             category.clear();
             package.clear();
-            s = portage->linkDependency(s, category, package);
-            if(category.size() && package.size())
+            portage->linkDependency(s, category, package);
+            atom = dependencyAtom(s);
+            if(category.isEmpty() || package.isEmpty() || atom.isEmpty() || checkedAtoms.contains(atom))
             {
-                s = category;
-                s.append('/');
-                s.append(package);
-                if(missingAtoms.contains(s) == false)
-                {
-                    missingAtoms.append(s);
-                }
+                continue;
             }
-        }
-
-        s = R"EOF(
-    select c.CATEGORY, p.PACKAGE, p.VERSION from PACKAGE p
-    inner join CATEGORY c on c.CATEGORYID = p.CATEGORYID
-    where p.INSTALLED != 0 and c.CATEGORY || '/' || p.PACKAGE in (
-    )EOF";
-
-        if(missingAtoms.count() > 0)
-        {
-            QString q = ",?";
+            checkedAtoms.append(atom);
 
-            s.append('?');
-            s.append(q.repeated(missingAtoms.count() - 1));
-            s.append(")");
-
-            query.prepare(s);
-            foreach(s, missingAtoms)
+            query.bindValue(0, category);
+            query.bindValue(1, package);
+            if(sqlFunctions)
             {
-                query.addBindValue(s);
+                query.bindValue(2, atom);
             }
 
-            if(query.exec() && query.first())
+            if(query.exec() && query.first() == false)
             {
-                do
+                s = QString("%1/%2").arg(category, package);
+                if(missingAtoms.contains(s) == false)
                 {
-                    s = QString("%1/%2").arg(query.value(0).toString(), query.value(1).toString());
-                    missingAtoms.removeAll(s);
-                } while(query.next());
+                    missingAtoms.append(s);
+                }
             }
         }
     }
@@ -1148,18 +1066,7 @@ QString printDependencies(QStringList dependencies, QSqlQuery& query, bool flagM
             inner join PACKAGE p2 on p2.PACKAGE=p.PACKAGE and p2.CATEGORYID=p.CATEGORYID and
                 p2.SLOT is p.SLOT and p2.PACKAGEID != p.PACKAGEID and p2.INSTALLED=0 and p2.MASKED=0 and
                 p2.VERSION != '9999' and p2.VERSION != '99999' and p2.VERSION != '999999' and p2.VERSION != '9999999' and p2.VERSION != '99999999' and p2.VERSION != '999999999' and
-            (
-                (p2.V1 > p.V1) or
-                (p2.V1 is p.V1 and p2.V2 > p.V2) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 > p.V3) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 > p.V4) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 > p.V5) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 > p.V6) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 > p.V7) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 > p.V8) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 is p.V8 and p2.V9 > p.V9) or
-                (p2.V1 is p.V1 and p2.V2 is p.V2 and p2.V3 is p.V3 and p2.V4 is p.V4 and p2.V5 is p.V5 and p2.V6 is p.V6 and p2.V7 is p.V7 and p2.V8 is p.V8 and p2.V9 is p.V9 and p2.V10 > p.V10)
-            )
+                p2.VERSIONKEY > p.VERSIONKEY
             where p.INSTALLED != 0 and
             (
                 (p.STATUS is null or p.STATUS=0) or
@@ -15,11 +15,20 @@
 // Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
 
 #include "versionstring.h"
-#include "k9portage.h"
-#include "globals.h"
 
-#include <QRegularExpression>
 #include <QDebug>
+#include <QHash>
+#include <QReadWriteLock>
+
+#include <limits>
+#include <string.h>
+
+// Versions parsed so far, shared by every thread. The same few strings come up over and over
+// (atoms in package.mask, the installed and repo copies of an ebuild, match() filters), so
+// each is only scanned once.
+static QHash<QString, VersionString> internedVersions;
+static QReadWriteLock internLock;
+const int maxInternedVersions = 65536; // start over past this, rather than grow without bound
 
 /*
 Refer to https://devmanual.gentoo.org/ebuild-writing/file-format/index.html
@@ -53,290 +62,244 @@ VersionString::VersionString()
 
 void VersionString::parse(QString input)
 {
-    QRegularExpressionMatch match;
-    QString s;
+    {
+        QReadLocker locker(&internLock);
+        QHash<QString, VersionString>::const_iterator it = internedVersions.constFind(input);
+        if(it != internedVersions.constEnd())
+        {
+            *this = it.value(); // implicitly shared, so this only bumps reference counts
+            return;
+        }
+    }
+
+    scan(input);
+
+    QWriteLocker locker(&internLock);
+    if(internedVersions.count() >= maxInternedVersions)
+    {
+        internedVersions.clear();
+    }
+    internedVersions.insert(input, *this);
+}
+
+void VersionString::clearCache()
+{
+    QWriteLocker locker(&internLock);
+    internedVersions.clear();
+}
+
+void VersionString::scan(const QString& input)
+{
     pvr = input;
-    int position = 0;
-    int oldPosition = -1;
     components.clear();
     vx.clear();
+    vi.clear();
     vx.reserve(MAXVX);
-    while(position < input.size() && position != oldPosition)
-    {
-        oldPosition = position;
+    vi.reserve(MAXVX);
 
-#if QT_VERSION < 0x060000
-        match = portage->separator.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchoredMatchOption);
-#else
-        match = portage->separator.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
-#endif
-        if(match.hasMatch())
+    // split into runs of digits and runs of letters; anything else just separates them
+    const QChar* s = input.constData();
+    const int length = input.size();
+    int position = 0;
+    int start;
+    ushort c;
+    while(position < length)
+    {
+        start = position;
+        c = s[position].unicode();
+        if(c >= '0' && c <= '9')
         {
-            position = match.capturedEnd();
+            do
+            {
+                position++;
+            } while(position < length && s[position].unicode() >= '0' && s[position].unicode() <= '9');
         }
-
-#if QT_VERSION < 0x060000
-        match = portage->digitVersion.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchoredMatchOption);
-#else
-        match = portage->digitVersion.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
-#endif
-        if(match.hasMatch())
+        else if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'))
         {
-            s = match.captured(1);
-            components.append(s);
-            vx.append(s);
-            position = match.capturedEnd();
+            do
+            {
+                position++;
+                c = position < length ? s[position].unicode() : 0;
+            } while((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z'));
         }
         else
         {
-#if QT_VERSION < 0x060000
-            match = portage->alphaVersion.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchoredMatchOption);
-#else
-            match = portage->alphaVersion.match(input, position, QRegularExpression::NormalMatch, QRegularExpression::AnchorAtOffsetMatchOption);
-#endif
-            if(match.hasMatch())
-            {
-                s = match.captured(1);
-                components.append(s);
-                vx.append(s);
-                position = match.capturedEnd();
-            }
-            else
-            {
-                break; // this shouldn't happen
-            }
+            position++;
+            continue;
         }
+
+        components.append(input.mid(start, position - start));
     }
 
     QString revision = "0";
-    QRegularExpression digitsRegEx("^\\d+$");
-    for(int i = 0; i < vx.count(); i++)
+    qint64 revisionValue = 0;
+    qint64 value;
+    int suffix;
+    const int count = components.count();
+    for(int i = 0; i < count; i++)
     {
-        s = vx.at(i);
+        const QString& component = components.at(i);
+        const bool hasNext = (i + 1) < count;
 
         // alpha, beta, pre, and rc release numbers need to be treated as negative numbers
         // so that we can get the SQL sort order functionality to work right.
-        if(s == "alpha" && (i+1) < vx.count())
+        if(hasNext && (suffix = suffixOffset(component)) != 0)
         {
-            vx[i] = QString::number(-40000 + vx.at(i+1).toInt());
-            vx.removeAt(i+1);
+            value = suffix + number(components.at(i + 1));
+            vx.append(QString::number(value));
+            vi.append(value);
+            i++;
         }
-        else if(s == "beta" && (i+1) < vx.count())
-        {
-            vx[i] = QString::number(-30000 + vx.at(i+1).toInt());
-            vx.removeAt(i+1);
-        }
-        else if(s == "pre" && (i+1) < vx.count())
-        {
-            vx[i] = QString::number(-20000 + vx.at(i+1).toInt());
-            vx.removeAt(i+1);
-        }
-        else if(s == "rc" && (i+1) < vx.count())
-        {
-            vx[i] = QString::number(-10000 + vx.at(i+1).toInt());
-            vx.removeAt(i+1);
-        }
-        else if(s == "r" && (i+1) < vx.count())
+        else if(hasNext && component == QLatin1String("r"))
         {
             // 'r' revision numbers should be treated as a positive number, but we want to strip out the
             // letter 'r' to save database Vx columns and we want the revision number to be the very least
             // significant tuple rather than being mixed in somewhere else.
-
-            revision = vx.at(i+1);
-            vx.removeAt(i);
-            vx.removeAt(i);
+            revision = components.at(i + 1);
+            revisionValue = number(revision);
+            i++;
         }
-        else if(s == "p" && (i+1) < vx.count() && vx.at(i+1).contains(digitsRegEx))
+        else if(hasNext && component == QLatin1String("p") && components.at(i + 1).at(0).isDigit())
         {
             // 'p' patch releases should be treated as a positive number, but we want to strip out the
             // letter 'p' to save database Vx columns for the really crazy long version numbers some packages have.
-
-            vx[i] = vx.at(i+1);
-            vx.removeAt(i+1);
+            vx.append(components.at(i + 1));
+            vi.append(number(components.at(i + 1)));
+            i++;
+        }
+        else
+        {
+            vx.append(component);
+            vi.append(number(component));
         }
     }
 
     // if any of the Vx columns are left as a NULL, it would make the SQL code much more complicated.
     // to avoid that, we need to pad out any unused tuples to being a "0" instead.
-    for(int i = 0; i < (MAXVX - 1); i++)
+    while(vx.count() < (MAXVX - 1))
     {
-        if(i >= vx.count())
-        {
-            vx.append("0");
-        }
-
-        s = vx.at(i);
-        if(s.isEmpty())
-        {
-            vx[i] = "0";
-        }
+        vx.append(QStringLiteral("0"));
+        vi.append(0);
     }
 
     // revision number always as least significant Vx column (V10). If no revision number specified,
     // it will be defaulted to "0" instead of NULL (code above during declaration of 'revision' variable).
     vx.append(revision);
+    vi.append(revisionValue);
 
-    qint64 i;
-    bool ok;
-    vi.clear();
-    vi.reserve(MAXVX);
-    const int vxCount = vx.count();
-    for(int j = 0; j < vxCount; j++)
+    buildKey();
+}
+
+int VersionString::suffixOffset(const QString& component)
+{
+    if(component == QLatin1String("alpha"))
+    {
+        return -40000;
+    }
+    else if(component == QLatin1String("beta"))
     {
-        s = vx.at(j);
-        i = s.toLongLong(&ok);
-        if(ok == false)
+        return -30000;
+    }
+    else if(component == QLatin1String("pre"))
+    {
+        return -20000;
+    }
+    else if(component == QLatin1String("rc"))
+    {
+        return -10000;
+    }
+    return 0;
+}
+
+// Value of a run of digits, or 0 for letters and numbers too big to fit.
+qint64 VersionString::number(const QString& component)
+{
+    const QChar* s = component.constData();
+    const int length = component.size();
+    quint64 value = 0;
+    ushort c;
+    for(int i = 0; i < length; i++)
+    {
+        c = s[i].unicode();
+        if(c < '0' || c > '9')
         {
-//            qDebug() << "couldn't convert:" << s;
-            i = 0;
+            return 0;
         }
-        vi.append(i);
+
+        if(value > (quint64(std::numeric_limits<qint64>::max()) - (c - '0')) / 10)
+        {
+            return 0;
+        }
+        value = value * 10 + (c - '0');
     }
+    return qint64(value);
 }
 
 bool VersionString::match(QString filter, QString version2) const
 {
-    if(filter == "=" && version2.contains("*") == false)
+    if(filter == "=")
     {
+        if(version2.endsWith('*'))
+        {
+            version2.chop(1);
+            return globMatch(pvr, version2);
+        }
         return version2 == pvr;
     }
 
     VersionString vb;
     vb.parse(version2);
-    int a;
-    int b;
-    int i;
-
-    if(filter == "=")
-    {
-        for(i = 0; i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(vb.vx.at(i).endsWith('*'))
-            {
-                if(a == b)
-                {
-                    return true;
-                }
-                return false;
-            }
-
-            if(a != b)
-            {
-                return false;
-            }
-        }
-
-        // both versions are equal
-        return true;
-    }
 
     if(filter == "<=")
     {
-        for(i = 0; i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(a > b)
-            {
-                return false;
-            }
-
-            if(a < b)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return true;
+        return compare(*this, vb) <= 0;
     }
 
     if(filter == ">=")
     {
-        for(i = 0; i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(a < b)
-            {
-                return false;
-            }
-
-            if(a > b)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return true;
+        return compare(*this, vb) >= 0;
     }
 
-
     if(filter == "<")
     {
-        for(i = 0; i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(a > b)
-            {
-                return false;
-            }
-
-            if(a < b)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return false;
+        return compare(*this, vb) < 0;
     }
 
     if(filter == ">")
     {
-        for(i = 0; i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(a < b)
-            {
-                return false;
-            }
-
-            if(a > b)
-            {
-                return true;
-            }
-        }
-
-        // both versions are equal
-        return false;
+        return compare(*this, vb) > 0;
     }
 
     if(filter == "~")
     {
-        for(i = 0; i < (MAXVX-1) && i < vb.vx.count() && i < vx.count(); i++)
-        {
-            a = vi.at(i);
-            b = vb.vi.at(i);
-            if(a != b)
-            {
-                return false;
-            }
-        }
-
         // both versions are equal (while ignoring any -rX revision number differences)
-        return true;
+        return compare(*this, vb, false) == 0;
     }
 
     qDebug() << "Unknown filter op:" << filter << "App Version:" << pvr << "Match Version" << version2;
     return false;
 }
 
+bool VersionString::globMatch(const QString& version, const QString& prefix)
+{
+    if(version.startsWith(prefix) == false)
+    {
+        return false;
+    }
+
+    if(prefix.isEmpty() || version.length() == prefix.length())
+    {
+        return true;
+    }
+
+    const QChar next = version.at(prefix.length());
+    if(next == '.' || next == '_' || next == '-')
+    {
+        return true;
+    }
+    return prefix.at(prefix.length() - 1).isDigit() != next.isDigit();
+}
+
 QString VersionString::cut(int index)
 {
     if(index >= 0 && index < components.count())
@@ -357,225 +320,202 @@ QString VersionString::cutInternalVx(int index)
     return QString();
 }
 
-QString VersionString::revision()
+// pre has to be tried before p
+static const struct
 {
-    int i = pvr.indexOf("-r");
-    if(i >= 0)
-    {
-        return pvr.mid(i + 2);
-    }
-
-    return "0";
-}
+    const char* name;
+    int length;
+    char rank;
+} suffixes[] =
+{
+    {"alpha", 5, 0x01}, {"beta", 4, 0x02}, {"pre", 3, 0x03}, {"rc", 2, 0x04}, {"p", 1, 0x06}
+};
+const int suffixCount = sizeof(suffixes) / sizeof(suffixes[0]);
 
-QString VersionString::pv()
+static bool startsWith(const QChar* p, const QChar* end, const char* s, int length)
 {
-    int i = pvr.indexOf("-r");
-    if(i >= 0)
+    if(end - p < length)
     {
-        return pvr.left(i);
+        return false;
     }
 
-    return pvr;
+    for(int i = 0; i < length; i++)
+    {
+        if(p[i].unicode() != ushort(s[i]))
+        {
+            return false;
+        }
+    }
+    return true;
 }
 
-QString VersionString::pr()
+int VersionString::compare(const VersionString& a, const VersionString& b, bool withRevision)
 {
-    int i = pvr.indexOf("-r");
-    if(i >= 0)
+    const int aLength = withRevision ? a.key.size() : a.revisionOffset;
+    const int bLength = withRevision ? b.key.size() : b.revisionOffset;
+    const int result = memcmp(a.key.constData(), b.key.constData(), qMin(aLength, bLength));
+    if(result != 0)
     {
-        return pvr.mid(i + 1);
+        return result;
     }
-
-    return "r0";
+    return aLength - bLength;
 }
 
-void VersionString::greaterThanEqualToSQL(QString& clauses)
+// Packs pvr into bytes that memcmp orders the way PMS section 3.3 compares versions:
+//
+//   numeric components  0x22, digit count, digits (leading zeros stripped) for the first component
+//                       and any other that doesn't start with a 0. Those that do start with a 0
+//                       compare as strings: 0x21, digits (trailing zeros stripped), 0x00.
+//   end of components   0x10, so the version with more components is newer
+//   letter              the letter, or 0x01 when there isn't one
+//   suffixes            0x01 alpha, 0x02 beta, 0x03 pre, 0x04 rc, 0x06 p, each followed by its number
+//                       like a first component, then 0x05 (so a missing suffix sorts after rc, before p)
+//   revision            number like a first component, 0 when there isn't one
+//
+// Anything that doesn't fit the grammar (like the * of an atom) is left out.
+void VersionString::buildKey()
 {
-    int count = vx.count();
-    QString s;
-    if(count == 1)
-    {
-        s = QString("(V1 >= %1)").arg(vx.at(0));
-    }
-    else if(count >= 2)
-    {
-        s = QString("(V1 > %1 or (V1 = %1 and (%2)))").arg(escapeSql(vx.at(0)), greaterThanEqualToSQL(1));
-    }
+    key.clear();
+    key.reserve(pvr.size() + 16);
 
-    if(s.isEmpty() == false)
+    const QChar* p = pvr.constData();
+    const QChar* end = p + pvr.size();
+    const QChar* start;
+    bool first = true;
+    while(true)
     {
-        if(clauses.isEmpty() == false)
+        start = p;
+        while(p < end && p->unicode() >= '0' && p->unicode() <= '9')
         {
-            clauses.append(" and ");
+            p++;
+        }
+        if(p == start)
+        {
+            break;
         }
-        clauses.append(s);
-    }
-}
-
-QString VersionString::greaterThanEqualToSQL(int i)
-{
-    int count = vx.count();
-    if(i >= count)
-    {
-        return "";
-    }
 
-    QString s;
+        appendNumber(key, start, p, first || start->unicode() != '0');
+        first = false;
 
-    if(i + 2 <= count && i + 1 < MAXVX)
-    {
-        s = QString("V%1 > %2 or (V%1 = %2 and (%3))").arg(i+1).arg(escapeSql(vx.at(i)), greaterThanEqualToSQL(i+1));
-    }
-    else
-    {
-        s = QString("V%1 >= %2").arg(i+1).arg(escapeSql(vx.at(i)));
+        if(p + 1 < end && p->unicode() == '.' && p[1].unicode() >= '0' && p[1].unicode() <= '9')
+        {
+            p++;
+            continue;
+        }
+        break;
     }
-    return s;
-}
+    key.append(char(0x10));
 
-void VersionString::lessThanEqualToSQL(QString& clauses)
-{
-    int count = vx.count();
-    QString s;
-    if(count == 1)
+    if(p < end && p->unicode() >= 'a' && p->unicode() <= 'z')
     {
-        s = QString("(V1 <= %1)").arg(vx.at(0));
+        key.append(char(p->unicode()));
+        p++;
     }
-    else if(count >= 2)
+    else
     {
-        s = QString("(V1 < %1 or (V1 = %1 and (%2)))").arg(escapeSql(vx.at(0)), lessThanEqualToSQL(1));
+        key.append(char(0x01));
     }
 
-    if(s.isEmpty() == false)
+    int i;
+    while(p < end && p->unicode() == '_')
     {
-        if(clauses.isEmpty() == false)
+        p++;
+        for(i = 0; i < suffixCount; i++)
         {
-            clauses.append(" and ");
+            if(startsWith(p, end, suffixes[i].name, suffixes[i].length))
+            {
+                break;
+            }
+        }
+        if(i == suffixCount)
+        {
+            break;
         }
-        clauses.append(s);
-    }
-}
 
-QString VersionString::lessThanEqualToSQL(int i)
-{
-    int count = vx.count();
-    if(i >= count)
-    {
-        return "";
+        p += suffixes[i].length;
+        key.append(suffixes[i].rank);
+        start = p;
+        while(p < end && p->unicode() >= '0' && p->unicode() <= '9')
+        {
+            p++;
+        }
+        appendNumber(key, start, p, true);
     }
+    key.append(char(0x05));
 
-    QString s;
-
-    if(i + 2 <= count && i + 1 < MAXVX)
+    revisionOffset = key.size();
+    start = p;
+    if(p + 1 < end && p->unicode() == '-' && p[1].unicode() == 'r')
     {
-        s = QString("V%1 < %2 or (V%1 = %2 and (%3))").arg(i+1).arg(escapeSql(vx.at(i)), lessThanEqualToSQL(i+1));
-    }
-    else
-    {
-        s = QString("V%1 <= %2").arg(i+1).arg(escapeSql(vx.at(i)));
+        start = p = p + 2;
+        while(p < end && p->unicode() >= '0' && p->unicode() <= '9')
+        {
+            p++;
+        }
     }
-    return s;
+    appendNumber(key, start, p, true);
 }
 
-QString VersionString::greaterThanSQL(int i)
+void VersionString::appendNumber(QByteArray& out, const QChar* start, const QChar* end, bool integer)
 {
-    int count = vx.count();
-    if(i >= count)
-    {
-        return "";
-    }
-
-    QString s;
-
-    if(i + 2 <= count && i + 1 < MAXVX)
+    if(integer)
     {
-        s = QString("V%1 > %2 or (V%1 = %2 and (%3))").arg(i+1).arg(escapeSql(vx.at(i)), greaterThanSQL(i+1));
+        while(start < end && start->unicode() == '0')
+        {
+            start++;
+        }
+        out.append(char(0x22));
+        out.append(char(qMin<int>(end - start, 255)));
     }
     else
     {
-        s = QString("V%1 > %2").arg(i+1).arg(escapeSql(vx.at(i)));
+        while(end > start && end[-1].unicode() == '0')
+        {
+            end--;
+        }
+        out.append(char(0x21));
     }
-    return s;
-}
 
-void  VersionString::greaterThanSQL(QString& clauses)
-{
-    int count = vx.count();
-    QString s;
-    if(count == 1)
+    for(; start < end; start++)
     {
-        s = QString("(V1 > %1)").arg(vx.at(0));
-    }
-    else if(count >= 2)
-    {
-        s = QString("(V1 > %1 or (V1 = %1 and (%2)))").arg(escapeSql(vx.at(0)), greaterThanSQL(1));
+        out.append(char(start->unicode()));
     }
 
-    if(s.isEmpty() == false)
+    if(integer == false)
     {
-        if(clauses.isEmpty() == false)
-        {
-            clauses.append(" and ");
-        }
-        clauses.append(s);
+        out.append('\0');
     }
-
 }
 
-QString VersionString::lessThanSQL(int i)
+QString VersionString::revision() const
 {
-    int count = vx.count();
-    if(i >= count)
+    int i = pvr.indexOf("-r");
+    if(i >= 0)
     {
-        return "";
+        return pvr.mid(i + 2);
     }
 
-    QString s;
-
-    if(i + 2 <= count && i + 1 < MAXVX)
-    {
-        s = QString("V%1 < %2 or (V%1 = %2 and (%3))").arg(i+1).arg(escapeSql(vx.at(i)), lessThanSQL(i+1));
-    }
-    else
-    {
-        s = QString("V%1 < %2").arg(i+1).arg(escapeSql(vx.at(i)));
-    }
-    return s;
+    return "0";
 }
 
-void VersionString::lessThanSQL(QString& clauses)
+QString VersionString::pv()
 {
-    int count = vx.count();
-    QString s;
-    if(count == 1)
-    {
-        s = QString("(V1 < %1)").arg(vx.at(0));
-    }
-    else if(count >= 2)
+    int i = pvr.indexOf("-r");
+    if(i >= 0)
     {
-        s = QString("(V1 < %1 or (V1 = %1 and (%2)))").arg(escapeSql(vx.at(0)), lessThanSQL(1));
+        return pvr.left(i);
     }
 
-    if(s.isEmpty() == false)
-    {
-        if(clauses.isEmpty() == false)
-        {
-            clauses.append(" and ");
-        }
-        clauses.append(s);
-    }
+    return pvr;
 }
 
-QString VersionString::escapeSql(QString s)
+QString VersionString::pr()
 {
-    bool ok;
-    s.toInt(&ok);
-    if(ok)
+    int i = pvr.indexOf("-r");
+    if(i >= 0)
     {
-        return s;
+        return pvr.mid(i + 1);
     }
 
-    s.replace("'", "''");
-    return QString("'%1'").arg(s);
+    return "r0";
 }
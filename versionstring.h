@@ -18,6 +18,7 @@
 #define VERSIONSTRING_H
 
 #include <QString>
+#include <QByteArray>
 #include <QVector>
 
 #define MAXVX 10
@@ -27,12 +28,33 @@ class VersionString
 public:
     VersionString();
 
+    // Scans input once per process; later calls with the same string copy the cached result.
     void parse(QString input);
+    static void clearCache(void); // forgets every interned version, so the next parse() scans again
     bool match(QString filter, QString version2) const;
 
+    // =cat/pkg-1.2* matching: version starts with prefix, and only on a boundary between
+    // version parts, so 1.2* matches 1.2, 1.2.3 and 1.2_rc1 but not 1.20 (portage bug 560466).
+    static bool globMatch(const QString& version, const QString& prefix);
+
     QString cut(int index);
     QString cutInternalVx(int index);
 
+    // The version packed so that comparing two keys with memcmp (or SQLite's blob
+    // ordering) sorts them in PMS order, the same as compare() does.
+    QByteArray sortKey() const { return key; }
+
+    // Returns <0, 0 or >0 as a is older than, the same as or newer than b, following
+    // the PMS version comparison rules. Doesn't allocate. With withRevision false, -rN is ignored (the ~ operator).
+    static int compare(const VersionString& a, const VersionString& b, bool withRevision = true);
+
+    bool operator<(const VersionString& other) const { return compare(*this, other) < 0; }
+    bool operator<=(const VersionString& other) const { return compare(*this, other) <= 0; }
+    bool operator>(const VersionString& other) const { return compare(*this, other) > 0; }
+    bool operator>=(const VersionString& other) const { return compare(*this, other) >= 0; }
+    bool operator==(const VersionString& other) const { return compare(*this, other) == 0; }
+    bool operator!=(const VersionString& other) const { return compare(*this, other) != 0; }
+
     // Package version and revision (if any), for example 6.3, 6.3-r1.
     QString pvr;
 
@@ -44,26 +66,22 @@ public:
     QString pr();
 
     // Package revision without the r. Returns "0" if no revision exists.
-    QString revision();
-
-    void greaterThanEqualToSQL(QString& clauses);
-    QString greaterThanEqualToSQL(int i);
-
-    void lessThanEqualToSQL(QString& clauses);
-    QString lessThanEqualToSQL(int i);
-
-    void greaterThanSQL(QString& clauses);
-    QString greaterThanSQL(int i);
-
-    void lessThanSQL(QString& clauses);
-    QString lessThanSQL(int i);
+    QString revision() const;
 
     QVector<QString> components; //verCut compatible version components
     QVector<QString> vx; // internal V1.V2.V3.V4.V5.rX version components
     QVector<qint64> vi;
 
 protected:
-    QString escapeSql(QString s);
+    void scan(const QString& input);
+    static int suffixOffset(const QString& component);
+    static qint64 number(const QString& component);
+
+    void buildKey();
+    static void appendNumber(QByteArray& out, const QChar* start, const QChar* end, bool integer);
+
+    QByteArray key; // see buildKey()
+    int revisionOffset = 0; // where the -rN part of key starts
 };
 
 #endif // VERSIONSTRING_H